@@ -0,0 +1,89 @@
+#define CATCH_CONFIG_ENABLE_BENCHMARKING
+#include "solver/fem/System.hpp"
+#include "solver/fem/elements/BeamElement.hpp"
+#include <catch2/catch.hpp>
+
+TEST_CASE("beam-internal-forces")
+{
+    // Internal forces of a curved, deformed beam with N elements, evaluated element by element (scalar path)
+    // and by the batched kernel. The displacements are reassigned before each evaluation to invalidate the forces.
+
+    for(unsigned N: {20, 100}) {
+        System system;
+        std::vector<Node> nodes;
+        for(unsigned i = 0; i < N+1; ++i) {
+            double phi = 0.5*double(i)/N;
+            bool active = (i != 0);
+            nodes.push_back(system.create_node({active, active, active}, {std::sin(phi), 1.0 - std::cos(phi), phi}));
+        }
+
+        for(unsigned i = 0; i < N; ++i) {
+            BeamElement element(system, nodes[i], nodes[i+1], 1.0, system.get_distance(nodes[i], nodes[i+1]));
+            element.set_reference_angles(0.25/N, -0.25/N);
+            element.set_stiffness(1e5, 10.0, 1.0);
+            element.set_damping(0.1);
+            system.mut_elements().add(element, "beams");
+        }
+
+        VectorXd u = system.get_u() + 0.01*VectorXd::Random(system.dofs());
+        system.set_u(u);
+        system.set_v(VectorXd::Random(system.dofs()));
+
+        system.mut_elements().set_batching(false);
+        VectorXd q_scalar = system.get_q();
+        BENCHMARK("Scalar, N = " + std::to_string(N)) {
+            system.set_u(u);
+            return system.get_q()(0);
+        };
+
+        system.mut_elements().set_batching(true);
+        VectorXd q_batched = system.get_q();
+        BENCHMARK("Batched, N = " + std::to_string(N)) {
+            system.set_u(u);
+            return system.get_q()(0);
+        };
+
+        REQUIRE(q_batched.isApprox(q_scalar, 1e-12));
+    }
+}
+
+TEST_CASE("beam-tangent-stiffness")
+{
+    // Tangent stiffness of the same curved, deformed beam, evaluated element by element and by the batched kernel
+
+    for(unsigned N: {20, 100}) {
+        System system;
+        std::vector<Node> nodes;
+        for(unsigned i = 0; i < N+1; ++i) {
+            double phi = 0.5*double(i)/N;
+            bool active = (i != 0);
+            nodes.push_back(system.create_node({active, active, active}, {std::sin(phi), 1.0 - std::cos(phi), phi}));
+        }
+
+        for(unsigned i = 0; i < N; ++i) {
+            BeamElement element(system, nodes[i], nodes[i+1], 1.0, system.get_distance(nodes[i], nodes[i+1]));
+            element.set_reference_angles(0.25/N, -0.25/N);
+            element.set_stiffness(1e5, 10.0, 1.0);
+            system.mut_elements().add(element, "beams");
+        }
+
+        VectorXd u = system.get_u() + 0.01*VectorXd::Random(system.dofs());
+        system.set_u(u);
+
+        system.mut_elements().set_batching(false);
+        MatrixXd K_scalar = system.get_K().to_dense();
+        BENCHMARK("Scalar, N = " + std::to_string(N)) {
+            system.set_u(u);
+            return system.get_K().size();
+        };
+
+        system.mut_elements().set_batching(true);
+        MatrixXd K_batched = system.get_K().to_dense();
+        BENCHMARK("Batched, N = " + std::to_string(N)) {
+            system.set_u(u);
+            return system.get_K().size();
+        };
+
+        REQUIRE(K_batched.isApprox(K_scalar, 1e-12));
+    }
+}
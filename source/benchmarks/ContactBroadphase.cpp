@@ -0,0 +1,63 @@
+#define CATCH_CONFIG_ENABLE_BENCHMARKING
+#include "solver/model/BowModel.hpp"
+#include "solver/fem/elements/ContactHandler.hpp"
+#include "tests/TestSystems.hpp"
+#include <catch2/catch.hpp>
+
+TEST_CASE("contact-broadphase")
+{
+    // Broadphase update of a string with N points wrapping onto a curved limb with N/2 segments, alternating between
+    // two states with different contacts, by sweep and prune and by the chain window method.
+
+    for(unsigned N: {25, 100, 400}) {
+        // States with different contacts
+        VectorXd u0 = get_string_state(N, 0.0, 20.0/N);    // Magic numbers
+        VectorXd u1 = get_string_state(N, 0.5, 20.0/N);
+
+        for(auto broadphase: {ContactBroadphase::SweepAndPrune, ContactBroadphase::ChainWindow}) {
+            System system;
+            create_limb_and_string(system, N/2, N, broadphase);
+            auto& contact = system.get_elements().front<ContactHandler>("contact");
+
+            std::string name = (broadphase == ContactBroadphase::SweepAndPrune) ? "Sweep and prune" : "Chain window";
+            size_t k = 0;
+            BENCHMARK(name + ", N = " + std::to_string(N)) {
+                system.set_u((++k % 2 == 0) ? u0 : u1);
+                contact.update_contacts();
+                return k;
+            };
+        }
+    }
+}
+
+TEST_CASE("contact-broadphase-simulation")
+{
+    // Dynamic simulation of the default bow with 20 limb elements and N string elements with both broadphase methods.
+    // Each simulation takes a few seconds, so run with few samples, e.g. --benchmark-samples 3.
+
+    for(int N: {100, 200}) {
+        InputData input;
+        input.settings.n_limb_elements = 20;
+        input.settings.n_string_elements = N;
+
+        SimulationOptions options_sap;
+        options_sap.contact_broadphase = ContactBroadphase::SweepAndPrune;
+
+        SimulationOptions options_chain;
+        options_chain.contact_broadphase = ContactBroadphase::ChainWindow;
+
+        double v_sap = 0.0;
+        BENCHMARK("Sweep and prune, N = " + std::to_string(N)) {
+            v_sap = BowModel::simulate(input, SimulationMode::Dynamic, [](int, int){ }, options_sap).dynamics.final_vel_arrow;
+            return v_sap;
+        };
+
+        double v_chain = 0.0;
+        BENCHMARK("Chain window, N = " + std::to_string(N)) {
+            v_chain = BowModel::simulate(input, SimulationMode::Dynamic, [](int, int){ }, options_chain).dynamics.final_vel_arrow;
+            return v_chain;
+        };
+
+        REQUIRE(v_chain == v_sap);
+    }
+}
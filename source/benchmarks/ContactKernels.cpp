@@ -0,0 +1,55 @@
+#define CATCH_CONFIG_ENABLE_BENCHMARKING
+#include "solver/fem/System.hpp"
+#include "solver/fem/elements/ContactElement.hpp"
+#include "solver/fem/elements/ContactHandler.hpp"
+#include "tests/TestSystems.hpp"
+#include <catch2/catch.hpp>
+
+TEST_CASE("contact-internal-forces")
+{
+    // Contact forces of a string with N points wrapping onto a curved limb with N/2 + 1 segments (same geometry as create_limb_and_string),
+    // evaluated by individual contact elements for the pairs of each point with the segments around it (scalar path) and by the
+    // batched kernel of the contact handler. The velocities are reassigned before each evaluation to invalidate the forces
+    // without repeating the broadphase. The number of segments is chosen such that no point lies exactly on the boundary between
+    // two segments, where the contact test of both evaluations could round differently.
+
+    for(size_t N: {25, 100, 400}) {
+        size_t n_segments = N/2 + 1;
+        VectorXd u = get_string_state(N, 0.0, 20.0/N);    // Magic numbers
+        VectorXd v = VectorXd::Zero(u.size());
+
+        System system_elements;
+        std::vector<Node> limb;
+        for(size_t i = 0; i < n_segments + 1; ++i) {
+            double phi = 1.5*i/n_segments;
+            limb.push_back(system_elements.create_node({false, false, false}, {std::sin(phi), 1.0 - std::cos(phi), phi}));
+        }
+        for(size_t j = 0; j < N; ++j) {
+            Node point = system_elements.create_node({true, true, false}, {0.0, 0.0, 0.0});
+            size_t nearest = std::min(j*n_segments/(N - 1), n_segments - 1);
+            for(size_t i = (nearest > 2) ? nearest - 2 : 0; i <= std::min(nearest + 2, n_segments - 1); ++i) {
+                system_elements.mut_elements().add(ContactElement(system_elements, limb[i], limb[i+1], point, 0.02, 0.02, ContactForce(1000.0, 0.01)));
+            }
+        }
+
+        System system_batched;
+        create_limb_and_string(system_batched, n_segments, N, ContactBroadphase::ChainWindow);
+
+        system_elements.set_u(u);
+        VectorXd q_elements = system_elements.get_q();
+        BENCHMARK("Scalar, N = " + std::to_string(N)) {
+            system_elements.set_v(v);
+            return system_elements.get_q()(0);
+        };
+
+        system_batched.set_u(u);
+        VectorXd q_batched = system_batched.get_q();
+        BENCHMARK("Batched, N = " + std::to_string(N)) {
+            system_batched.set_v(v);
+            return system_batched.get_q()(0);
+        };
+
+        REQUIRE(q_elements.norm() > 0.0);
+        REQUIRE(q_batched.isApprox(q_elements, 1e-12));
+    }
+}
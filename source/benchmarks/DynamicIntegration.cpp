@@ -0,0 +1,40 @@
+#define CATCH_CONFIG_ENABLE_BENCHMARKING
+#include "solver/model/BowModel.hpp"
+#include <catch2/catch.hpp>
+
+TEST_CASE("dynamic-integration")
+{
+    // Dynamic simulation of the default bow with N limb and string elements by the explicit central difference method
+    // and the implicit generalized-alpha method. The implicit method uses the smallest number of steps per sampling interval
+    // that reproduces the final arrow velocity of the explicit method with a relative error below 1e-4.
+    // Each simulation takes up to several seconds, so run with few samples, e.g. --benchmark-samples 3.
+
+    for(int N: {5, 10, 20, 40}) {
+        InputData input;
+        input.settings.n_limb_elements = N;
+        input.settings.n_string_elements = N;
+
+        auto final_arrow_velocity = [&](const SimulationOptions& options) {
+            return BowModel::simulate(input, SimulationMode::Dynamic, [](int, int){ }, options).dynamics.final_vel_arrow;
+        };
+
+        SimulationOptions options_explicit;
+        double v_explicit = final_arrow_velocity(options_explicit);
+
+        SimulationOptions options_implicit;
+        options_implicit.integration_method = IntegrationMethod::GeneralizedAlpha;
+        for(options_implicit.implicit_steps = 1; options_implicit.implicit_steps < 1024; options_implicit.implicit_steps *= 2) {
+            if(std::abs(final_arrow_velocity(options_implicit) - v_explicit) <= 1e-4*v_explicit) {
+                break;
+            }
+        }
+
+        BENCHMARK("Central difference, N = " + std::to_string(N)) {
+            return final_arrow_velocity(options_explicit);
+        };
+
+        BENCHMARK("Generalized-alpha, " + std::to_string(options_implicit.implicit_steps) + " steps per sample, N = " + std::to_string(N)) {
+            return final_arrow_velocity(options_implicit);
+        };
+    }
+}
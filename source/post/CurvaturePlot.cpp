@@ -50,10 +50,10 @@ void CurvaturePlot::updateAxes() {
         0.0
     );
 
-    for(size_t i = 0; i < states.kappa.size(); ++i) {
-        for(size_t j = 1; j < states.kappa[i].size(); j++) {
-            y_range.expand(quantity_curvature.getUnit().fromBase(states.kappa[i][j]));
-        }
+    if(!states.kappa.empty() && states.kappa.cols() > 1) {
+        auto kappa = states.kappa.matrix().rightCols(states.kappa.cols() - 1);
+        y_range.expand(quantity_curvature.getUnit().fromBase(kappa.minCoeff()));
+        y_range.expand(quantity_curvature.getUnit().fromBase(kappa.maxCoeff()));
     }
 
     this->setAxesLimits(x_range, y_range);
@@ -111,7 +111,7 @@ StaticOutputWidget::StaticOutputWidget(const OutputData& data)
     numbers->addValue("String force (strand)", data.statics.states.strand_force[data.statics.max_string_force_index],  Quantities::force);
 
     auto plot_shapes = new ShapePlot(data.setup.limb_properties, data.statics.states, 4);
-    auto plot_stress = new StressPlot(data.setup.limb_properties, data.statics.states);
+    auto plot_stress = new StressPlot(data.setup.limb_properties, data.statics.states, data.statics.min_stress_value, data.statics.max_stress_value);
     auto plot_curvature = new CurvaturePlot(data.setup.limb_properties, data.statics.states);
     auto plot_energy = new EnergyPlot(data.statics.states, data.statics.states.draw_length, "Draw length", Quantities::length, Quantities::energy);
     auto plot_combo = new ComboPlot();
@@ -191,7 +191,7 @@ DynamicOutputWidget::DynamicOutputWidget(const OutputData& data)
     numbers->addValue("Grip force", data.dynamics.states.grip_force[data.dynamics.max_grip_force_index], Quantities::force);
 
     auto plot_shapes = new ShapePlot(data.setup.limb_properties, data.dynamics.states, 0);
-    auto plot_stress = new StressPlot(data.setup.limb_properties, data.dynamics.states);
+    auto plot_stress = new StressPlot(data.setup.limb_properties, data.dynamics.states, data.dynamics.min_stress_value, data.dynamics.max_stress_value);
     auto plot_curvature = new CurvaturePlot(data.setup.limb_properties, data.dynamics.states);
     auto plot_energy = new EnergyPlot(data.dynamics.states, data.dynamics.states.time, "Time", Quantities::time, Quantities::energy);
     auto plot_combo = new ComboPlot();
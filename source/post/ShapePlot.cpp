@@ -132,12 +132,17 @@ void ShapePlot::updateAxes() {
         }
     };
 
+    // Only the extreme values of each node over all states are needed, which are found in a single pass over the columns
+    auto expand_columns = [&](const VectorColumn& x_values, const VectorColumn& y_values, const VectorXd& offset) {
+        if(!x_values.empty()) {
+            expand(x_values.matrix().colwise().minCoeff().transpose() + offset, y_values.matrix().colwise().minCoeff().transpose() + offset);
+            expand(x_values.matrix().colwise().maxCoeff().transpose() + offset, y_values.matrix().colwise().maxCoeff().transpose() + offset);
+        }
+    };
+
     expand(limb.x_pos, limb.y_pos);
-    for(size_t i = 0; i < states.time.size(); ++i) {
-        // Add 0.5*height as an estimated upper bound
-        expand(states.x_pos_limb[i] + 0.5*limb.height, states.y_pos_limb[i] + 0.5*limb.height);
-        expand(states.x_pos_string[i], states.y_pos_string[i]);
-    }
+    expand_columns(states.x_pos_limb, states.y_pos_limb, 0.5*limb.height);    // Add 0.5*height as an estimated upper bound
+    expand_columns(states.x_pos_string, states.y_pos_string, VectorXd::Zero(states.x_pos_string.cols()));
 
     this->setAxesLimits(x_range, y_range);
 }
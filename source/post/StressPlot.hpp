@@ -6,12 +6,15 @@
 
 class StressPlot: public PlotWidget {
 public:
-    StressPlot(const LimbProperties& limb, const BowStates& states);
+    // The extreme stresses of each layer over all states determine the axis limits
+    StressPlot(const LimbProperties& limb, const BowStates& states, const std::vector<double>& min_stress, const std::vector<double>& max_stress);
     void setStateIndex(int i);
 
 private:
     const LimbProperties& limb;
     const BowStates& states;
+    std::vector<double> min_stress;
+    std::vector<double> max_stress;
     int index;
 
     const Quantity& quantity_length;
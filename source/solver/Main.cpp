@@ -1,6 +1,8 @@
 #include <QtCore>
 #include "config.hpp"
 #include "model/BowModel.hpp"
+#include <algorithm>
+#include <map>
 #include <utility>
 #include <iostream>
 
@@ -14,6 +16,16 @@ int main(int argc, char* argv[]) {
     QCommandLineOption statics({"s", "static"}, "Run a static simulation.");
     QCommandLineOption dynamics({"d", "dynamic"}, "Run a dynamic simulation.");
     QCommandLineOption progress({"p", "progress"}, "Print simulation progress.");
+    QCommandLineOption adaptive_steps("adaptive-draw-steps", "Choose the steps of the static simulation adaptively and interpolate the results onto the draw steps.");
+    QCommandLineOption threads("threads", "Number of threads for assembling the system.", "n", "1");
+    QCommandLineOption deterministic("deterministic", "Produce bitwise identical results regardless of the number of threads.");
+    QCommandLineOption timestep("timestep-method", "Estimation of the highest natural frequency for the timestep: automatic (default), eigenvalues, element-bound, gershgorin or power-iteration.", "method", "automatic");
+    QCommandLineOption diagnostics("timestep-diagnostics", "Print the estimates of all timestep methods relative to the exact value.");
+    QCommandLineOption adaptive("adaptive-timestep", "Adapt the timestep of the dynamic simulation to the stiffness of the contacts between string and limbs.");
+    QCommandLineOption integration("integration-method", "Time integration of the dynamic simulation: central-difference (default) or generalized-alpha.", "method", "central-difference");
+    QCommandLineOption implicit_steps("implicit-steps", "Timesteps of the implicit method per sampling interval, subdivided where needed for accuracy.", "n", "4");
+    QCommandLineOption subcycling("subcycling", "Integrate stiff groups of elements with smaller timesteps than the rest of the bow.");
+    QCommandLineOption broadphase("contact-broadphase", "Search for contacts between limb and string: sweep-and-prune (default) or chain-window.", "method", "sweep-and-prune");
 
     QCoreApplication application(argc, argv);
     QCommandLineParser parser;
@@ -22,6 +34,16 @@ int main(int argc, char* argv[]) {
     parser.addOption(statics);
     parser.addOption(dynamics);
     parser.addOption(progress);
+    parser.addOption(adaptive_steps);
+    parser.addOption(threads);
+    parser.addOption(deterministic);
+    parser.addOption(timestep);
+    parser.addOption(diagnostics);
+    parser.addOption(subcycling);
+    parser.addOption(adaptive);
+    parser.addOption(integration);
+    parser.addOption(implicit_steps);
+    parser.addOption(broadphase);
     parser.addPositionalArgument("input", "Model file (.bow)");
     parser.addPositionalArgument("output", "Result file (.res)");
     parser.process(application);
@@ -61,19 +83,79 @@ int main(int argc, char* argv[]) {
             return 1;
         }
 
+        SimulationOptions options;
+        options.adaptive_draw_steps = parser.isSet(adaptive_steps);
+        options.threads = std::max(parser.value(threads).toUInt(), 1u);
+        options.deterministic = parser.isSet(deterministic);
+
+        std::map<QString, TimestepMethod> timestep_methods = {
+            {"eigenvalues", TimestepMethod::Eigenvalues},
+            {"element-bound", TimestepMethod::ElementBound},
+            {"gershgorin", TimestepMethod::Gershgorin},
+            {"power-iteration", TimestepMethod::PowerIteration},
+            {"automatic", TimestepMethod::Automatic}
+        };
+
+        if(timestep_methods.count(parser.value(timestep)) == 0) {
+            std::cerr << "Unknown timestep method." << std::endl;
+            return 1;
+        }
+
+        options.timestep_method = timestep_methods[parser.value(timestep)];
+        options.subcycling = parser.isSet(subcycling);
+        options.adaptive_timestep = parser.isSet(adaptive);
+
+        std::map<QString, IntegrationMethod> integration_methods = {
+            {"central-difference", IntegrationMethod::CentralDifference},
+            {"generalized-alpha", IntegrationMethod::GeneralizedAlpha}
+        };
+
+        if(integration_methods.count(parser.value(integration)) == 0) {
+            std::cerr << "Unknown integration method." << std::endl;
+            return 1;
+        }
+
+        options.integration_method = integration_methods[parser.value(integration)];
+        options.implicit_steps = std::max(parser.value(implicit_steps).toUInt(), 1u);
+
+        std::map<QString, ContactBroadphase> broadphases = {
+            {"sweep-and-prune", ContactBroadphase::SweepAndPrune},
+            {"chain-window", ContactBroadphase::ChainWindow}
+        };
+
+        if(broadphases.count(parser.value(broadphase)) == 0) {
+            std::cerr << "Unknown contact broadphase." << std::endl;
+            return 1;
+        }
+
+        options.contact_broadphase = broadphases[parser.value(broadphase)];
+
+        if(parser.isSet(diagnostics)) {
+            options.timestep_diagnostics = [&](TimestepMethod method, double omega, double omega_exact) {
+                for(auto& entry: timestep_methods) {
+                    if(entry.second == method) {
+                        std::cout << "Timestep method " << entry.first.toStdString() << ": omega_max = " << omega
+                                  << ", exact = " << omega_exact << ", ratio = " << omega/omega_exact << std::endl;
+                    }
+                }
+            };
+        }
+
         InputData input(input_path.toLocal8Bit().toStdString());    // toLocal8Bit() for Windows, since toStdString() would convert to UTF8
 
+        // The results are written while the simulation is running, without keeping all dynamic states in memory
+        OutputWriter writer(output_path.toLocal8Bit().toStdString());    // toLocal8Bit() for Windows, since toStdString() would convert to UTF8
+
         std::pair<int, int> previous = {-1, -1};
-        OutputData output = BowModel::simulate(input, mode, [&](int p1, int p2) {
+        BowModel::simulate(input, mode, [&](int p1, int p2) {
             if(p1 != previous.first || p2 != previous.second) {
                 previous = {p1, p2};
                 if(parser.isSet(progress)) {
                     std::cout << p1 << "\t" << p2 << std::endl;
                 }
             }
-        });
+        }, writer, options);
 
-        output.save(output_path.toLocal8Bit().toStdString());    // toLocal8Bit() for Windows, since toStdString() would convert to UTF8
         return 0;
     }
     catch(const std::exception& e) {
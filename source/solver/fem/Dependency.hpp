@@ -1,51 +1,93 @@
 #pragma once
 #include <vector>
-#include <stdexcept>
-#include <functional>
+#include <limits>
+#include <cstddef>
 
-// Todo: Remove is_valid() and set_valid() from public interface
-// Todo: Make depends_on(...) variadic
+// Lazily updated values with dependencies on other values.
+//
+// Every value has a revision counter that is incremented by mut(), so invalidating all dependents of a value is O(1).
+// A dependent value stores the revisions of its dependencies at the time of its last update and compares them
+// with the current ones on get(). Dependencies that are dependent values themselves are brought up to date first,
+// so changes propagate through the whole graph. The update functions are member functions of the owner of the values,
+// bound at compile time, which avoids heap-allocated closures.
 
-class DependentBase;
+// Todo: Remove is_valid() and set_valid() from public interface
 
 class IndependentBase {
 public:
-    void add_dependent(DependentBase& dependent) {
-        dependents.push_back(&dependent);
+    size_t revision() const {
+        return rev;
     }
 
 protected:
-    std::vector<DependentBase*> dependents;
+    size_t rev = 0;
 };
 
 class DependentBase: public IndependentBase {
 public:
     template<typename... Args>
-    void depends_on(IndependentBase& other, Args&... args) {
-        depends_on(other);
-        depends_on(args...);
-    }
-
-    void depends_on(IndependentBase& other) {
-        other.add_dependent(*this);
+    void depends_on(Args&... args) {
+        (add_dependency(args), ...);
     }
 
+    // Checks the revisions of the dependencies, updating dependent values among them first
     bool is_valid() const {
-        return valid;
+        bool result = valid;
+        for(auto& link: links) {
+            if(link.dependent != nullptr) {
+                link.dependent->refresh();
+            }
+
+            result = result && (link.node->revision() == link.seen);
+        }
+
+        return result;
     }
 
     void set_valid(bool val) const {
         valid = val;
-
-        if(!valid) {
-            for(auto d: dependents) {
-                d->set_valid(false);
-            }
+        for(auto& link: links) {
+            link.seen = val ? link.node->revision() : std::numeric_limits<size_t>::max();
         }
     }
 
 protected:
+    // Binds the update function to a member function F of the owner
+    template<class C, void (C::*F)() const>
+    void bind_update(const C* owner) {
+        context = owner;
+        update = [](const void* context) {
+            (static_cast<const C*>(context)->*F)();
+        };
+    }
+
+    void refresh() const {
+        if(!is_valid()) {
+            update(context);
+            set_valid(true);
+        }
+    }
+
+private:
+    struct Link {
+        const IndependentBase* node;
+        const DependentBase* dependent;    // Same as node if it is a dependent value, nullptr otherwise
+        mutable size_t seen;               // Revision of the node at the last update
+    };
+
+    void add_dependency(const IndependentBase& other) {
+        links.push_back({&other, nullptr, std::numeric_limits<size_t>::max()});
+    }
+
+    void add_dependency(const DependentBase& other) {
+        links.push_back({&other, &other, std::numeric_limits<size_t>::max()});
+    }
+
+    std::vector<Link> links;
     mutable bool valid = false;
+
+    void (*update)(const void*) = nullptr;
+    const void* context = nullptr;
 };
 
 template<typename T>
@@ -64,10 +106,7 @@ public:
     }
 
     T& mut() {
-        for(auto d: dependents) {
-            d->set_valid(false);
-        }
-
+        ++rev;
         return value;
     }
 
@@ -78,30 +117,35 @@ private:
 template<typename T>
 class Dependent: public DependentBase {
 public:
-    using F = std::function<void(void)>;
+    Dependent(const T& value)
+        : value(value)
+    {
 
-    void on_update(const F& f) {
-        update = f;
     }
 
-    const T& get() const {
-        if(!is_valid()) {
-            update();
-            set_valid(true);
-        }
+    Dependent() = default;
+
+    template<class C, void (C::*F)() const>
+    void on_update(const C* owner) {
+        bind_update<C, F>(owner);
+    }
 
+    const T& get() const {
+        refresh();
         return value;
     }
 
     T& mut() {
-        for(auto d: dependents) {
-            d->set_valid(false);
-        }
+        ++rev;
+        return value;
+    }
 
+    // Write access without incrementing the revision, for accumulating contributions during an update
+    // that already called mut(). Doesn't touch the revision counter, so it can be used by several threads.
+    T& mut_in_update() {
         return value;
     }
 
 private:
-    F update;
     T value;
 };
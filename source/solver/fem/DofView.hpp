@@ -1,7 +1,10 @@
 #pragma once
 #include "Node.hpp"
+#include "SystemMatrix.hpp"
 #include "solver/numerics/EigenTypes.hpp"
+#include <algorithm>
 #include <array>
+#include <vector>
 
 inline double get_by_dof(const VectorXd* vec_a, const VectorXd* vec_f, Dof dof) {
     if(vec_a && dof.active) {
@@ -31,36 +34,105 @@ inline void add_by_dof(VectorXd* vec_a, VectorXd* vec_f, Dof dof, double value)
     }
 }
 
+// Local-to-global index map of the DOFs of an element, computed once at construction.
+// The local positions and global indices of the active DOFs come first, followed by those of the fixed DOFs.
+// This allows gathering and scattering element vectors and matrices without branching on each entry.
 template<size_t N>
-inline Vector<N> get_by_dof(const VectorXd* vec_a, const VectorXd* vec_f, const std::array<Dof, N>& dofs) {
-    Vector<N> vec;
-    for(size_t i = 0; i < N; ++i) {
-        vec[i] = get_by_dof(vec_a, vec_f, dofs[i]);
+class DofMap {
+public:
+    DofMap(const std::array<Dof, N>& dofs)
+        : dofs(dofs), n_active(0)
+    {
+        size_t k = 0;
+        for(size_t i = 0; i < N; ++i) {
+            if(dofs[i].active) {
+                local[k] = i;
+                global[k] = dofs[i].index;
+                ++k;
+            }
+        }
+
+        n_active = k;
+        for(size_t i = 0; i < N; ++i) {
+            if(!dofs[i].active) {
+                local[k] = i;
+                global[k] = dofs[i].index;
+                ++k;
+            }
+        }
     }
-    return vec;
-}
 
-template<size_t N, class T>
-inline void set_by_dof(VectorXd* vec_a, VectorXd* vec_f, const std::array<Dof, N>& dofs, const T& values) {
-    for(size_t i = 0; i < N; ++i) {
-        set_by_dof(vec_a, vec_f, dofs[i], values[i]);
+    const Dof& operator[](size_t i) const {
+        return dofs[i];
     }
-}
 
-template<size_t N, class T>
-inline void add_by_dof(VectorXd* vec_a, VectorXd* vec_f, const std::array<Dof, N>& dofs, const T& values) {
-    for(size_t i = 0; i < N; ++i) {
-        add_by_dof(vec_a, vec_f, dofs[i], values[i]);
+    typename std::array<Dof, N>::const_iterator begin() const {
+        return dofs.begin();
     }
-}
 
-template<size_t N, class T>
-inline void add_by_dof(MatrixXd* mat, const std::array<Dof, N>& dofs, const T& values) {
-    for(size_t i = 0; i < N; ++i) {
-        for(size_t j = 0; j < N; ++j) {
-            if(dofs[i].active && dofs[j].active) {
-                (*mat)(dofs[i].index, dofs[j].index) += values(i, j);
+    typename std::array<Dof, N>::const_iterator end() const {
+        return dofs.end();
+    }
+
+    // Values of vec_a at the active and vec_f at the fixed DOFs, zero for the fixed DOFs if vec_f is nullptr
+    Vector<N> gather(const VectorXd& vec_a, const VectorXd* vec_f) const {
+        Vector<N> values = Vector<N>::Zero();
+        for(size_t k = 0; k < n_active; ++k) {
+            values[local[k]] = vec_a[global[k]];
+        }
+
+        if(vec_f) {
+            for(size_t k = n_active; k < N; ++k) {
+                values[local[k]] = (*vec_f)[global[k]];
             }
         }
+
+        return values;
     }
-}
+
+    // Adds the values at the active DOFs to vec_a and at the fixed DOFs to vec_f, if not nullptr
+    template<class T>
+    void scatter_add(VectorXd& vec_a, VectorXd* vec_f, const T& values) const {
+        for(size_t k = 0; k < n_active; ++k) {
+            vec_a[global[k]] += values[local[k]];
+        }
+
+        if(vec_f) {
+            for(size_t k = n_active; k < N; ++k) {
+                (*vec_f)[global[k]] += values[local[k]];
+            }
+        }
+    }
+
+    // Adds the entries of an element matrix that belong to pairs of active DOFs
+    template<class T>
+    void scatter_add(SystemMatrix& mat, const T& values) const {
+        for(size_t j = 0; j < n_active; ++j) {
+            for(size_t i = 0; i < n_active; ++i) {
+                mat.add(global[i], global[j], values(local[i], local[j]));
+            }
+        }
+    }
+
+    // Adds the entries of an element matrix that belong to pairs of active DOFs to a dense block,
+    // whose rows and columns belong to the given sorted global indices
+    template<class T>
+    void scatter_add(MatrixXd& mat, const std::vector<size_t>& indices, const T& values) const {
+        std::array<size_t, N> rows;
+        for(size_t k = 0; k < n_active; ++k) {
+            rows[k] = std::lower_bound(indices.begin(), indices.end(), global[k]) - indices.begin();
+        }
+
+        for(size_t j = 0; j < n_active; ++j) {
+            for(size_t i = 0; i < n_active; ++i) {
+                mat(rows[i], rows[j]) += values(local[i], local[j]);
+            }
+        }
+    }
+
+private:
+    std::array<Dof, N> dofs;
+    std::array<size_t, N> local;     // Local positions, active DOFs first
+    std::array<size_t, N> global;    // Global indices into the active or fixed vectors, same order as local
+    size_t n_active;                 // Number of active DOFs
+};
@@ -1,19 +1,57 @@
 #include "DynamicSolver.hpp"
 #include "System.hpp"
 #include <Eigen/Eigenvalues>
+#include <algorithm>
+#include <cmath>
+#include <limits>
 
-DynamicSolver::DynamicSolver(System& system, double dt, double f_sample, const StopFn& stop)
+// Bound for the highest natural frequency of the undamped system, lambda_max <= max_i sum_j |A_ij| with A = M^(-1/2)*K*M^(-1/2)
+static double gershgorin_bound(const SystemMatrix& K, const VectorXd& M) {
+    VectorXd S = M.cwiseSqrt().cwiseInverse();
+    VectorXd row_sums = VectorXd::Zero(M.size());
+
+    if(K.storage() == MatrixStorage::Dense) {
+        row_sums = (S.asDiagonal()*K.dense()*S.asDiagonal()).cwiseAbs().rowwise().sum();
+    }
+    else {
+        for(int j = 0; j < K.sparse().outerSize(); ++j) {
+            for(SparseMatrix::InnerIterator it(K.sparse(), j); it; ++it) {
+                row_sums(it.row()) += std::abs(S(it.row())*it.value()*S(it.col()));
+            }
+        }
+    }
+
+    return std::sqrt(row_sums.maxCoeff());
+}
+
+DynamicSolver::DynamicSolver(System& system, double dt, double f_sample, const StopFn& stop, const std::vector<SubcyclingLevel>& subcycling)
     : system(system),
       stop(stop),
       dt(dt),
-      n(std::max(std::ceil(1.0/(f_sample*dt)), 1.0))
+      dt_p(dt),
+      n(std::max(std::ceil(1.0/(f_sample*dt)), 1.0)),
+      f_sample(f_sample)
 {
     // Initialise previous displacement
     u_p2 = system.get_u() - dt*system.get_v() + dt*dt/2.0*system.get_a();
+
+    // The first level contains all groups that aren't assigned to one of the subcycling levels
+    if(!subcycling.empty()) {
+        levels.push_back({system.get_elements().get_keys(), 1});
+        for(auto& level: subcycling) {
+            for(auto& key: level.groups) {
+                levels[0].groups.erase(std::remove(levels[0].groups.begin(), levels[0].groups.end(), key), levels[0].groups.end());
+            }
+            levels.push_back(level);
+        }
+
+        q_levels.resize(levels.size());
+        q_revisions.resize(levels.size(), std::numeric_limits<size_t>::max());
+    }
 }
 
 // Estimate timestep based on maximum eigen frequency and a safety factor to account for nonlinearity of the system
-double DynamicSolver::estimate_timestep(const System& system, double factor) {
+double DynamicSolver::estimate_timestep(const System& system, double factor, TimestepMethod method) {
     /*
     // Version that includes damping
     // Problem: Calculation of eigenvalues is inefficient and not very robust
@@ -24,15 +62,7 @@ double DynamicSolver::estimate_timestep(const System& system, double factor) {
     return factor*2.0/mode.omega*(std::sqrt(1 + mode.zeta*mode.zeta) - mode.zeta);
     */
 
-    // Ignore damping and use selfadjoint solver, which is more efficient and can handle larger matrices
-    Eigen::GeneralizedSelfAdjointEigenSolver<MatrixXd>
-            eigen_solver(system.get_K(), system.get_M().asDiagonal(), Eigen::DecompositionOptions::EigenvaluesOnly);
-
-    if(eigen_solver.info() != Eigen::Success) {
-        throw std::runtime_error("Failed to compute eigenvalues of the system");
-    }
-
-    double omega_max = std::sqrt(eigen_solver.eigenvalues().maxCoeff());
+    double omega_max = estimate_max_frequency(system, method);
     if(omega_max == 0.0) {
         throw std::runtime_error("Can't estimate timestep for system with a zero eigenvalue");
     }
@@ -40,9 +70,186 @@ double DynamicSolver::estimate_timestep(const System& system, double factor) {
     return factor*2.0/omega_max;
 }
 
+// Damping is ignored, the eigenvalues are those of the symmetric matrix A = S*K*S with S = M^(-1/2)
+double DynamicSolver::estimate_max_frequency(const System& system, TimestepMethod method) {
+    const VectorXd& M = system.get_M();
+    if((M.array() <= 0.0).any()) {
+        throw std::runtime_error("Can't estimate timestep for system with zero masses");
+    }
+
+    // The dense eigenvalue decomposition gives the largest stable timestep and takes only milliseconds at the default mesh sizes,
+    // but grows with O(n^3) beyond that
+    if(method == TimestepMethod::Automatic) {
+        const size_t max_dofs = 500;    // Magic number
+        method = (system.dofs() <= max_dofs) ? TimestepMethod::Eigenvalues : TimestepMethod::Gershgorin;
+    }
+
+    VectorXd S = M.cwiseSqrt().cwiseInverse();
+    switch(method) {
+        case TimestepMethod::Eigenvalues: {
+            Eigen::GeneralizedSelfAdjointEigenSolver<MatrixXd>
+                    eigen_solver(system.get_K().to_dense(), M.asDiagonal(), Eigen::DecompositionOptions::EigenvaluesOnly);
+
+            if(eigen_solver.info() != Eigen::Success) {
+                throw std::runtime_error("Failed to compute eigenvalues of the system");
+            }
+
+            return std::sqrt(std::max(eigen_solver.eigenvalues().maxCoeff(), 0.0));
+        }
+
+        // Since K = sum(K_e) and M = sum(M_e) for any partition of the masses onto the elements,
+        // x^T*K*x <= sum(lambda_e*x_e^T*M_e*x_e) <= max(lambda_e)*x^T*M*x with the element eigenvalues lambda_e.
+        // The masses are distributed in proportion to the diagonal stiffness of the elements at each DOF.
+        case TimestepMethod::ElementBound: {
+            std::vector<std::vector<size_t>> indices;
+            std::vector<MatrixXd> matrices;
+            VectorXd k_sum = VectorXd::Zero(M.size());
+
+            for(auto& element: system.get_elements()) {
+                indices.emplace_back();
+                matrices.push_back(system.get_element_K(element, indices.back()));
+                for(size_t i = 0; i < indices.back().size(); ++i) {
+                    k_sum(indices.back()[i]) += std::abs(matrices.back()(i, i));
+                }
+            }
+
+            double lambda_max = 0.0;
+            for(size_t e = 0; e < matrices.size(); ++e) {
+                const MatrixXd& K_e = matrices[e];
+                if(K_e.size() == 0) {
+                    continue;
+                }
+
+                VectorXd S_e(K_e.rows());
+                for(size_t i = 0; i < indices[e].size(); ++i) {
+                    double share = (k_sum(indices[e][i]) > 0.0) ? std::abs(K_e(i, i))/k_sum(indices[e][i]) : 1.0;
+                    S_e(i) = (share > 0.0) ? 1.0/std::sqrt(share*M(indices[e][i])) : 0.0;    // Zero share only for zero rows, if K_e is semidefinite
+                }
+
+                MatrixXd A_e = S_e.asDiagonal()*K_e*S_e.asDiagonal();
+                if(A_e.rows() <= 32) {    // Magic number
+                    Eigen::SelfAdjointEigenSolver<MatrixXd> eigen_solver(A_e, Eigen::DecompositionOptions::EigenvaluesOnly);
+                    lambda_max = std::max(lambda_max, eigen_solver.eigenvalues().maxCoeff());
+                }
+                else {
+                    // Gershgorin bound for elements with many DOFs like the contact handler
+                    lambda_max = std::max(lambda_max, A_e.cwiseAbs().rowwise().sum().maxCoeff());
+                }
+            }
+
+            return std::sqrt(lambda_max);
+        }
+
+        case TimestepMethod::Gershgorin: {
+            return gershgorin_bound(system.get_K(), M);
+        }
+
+        // Rayleigh quotient after a fixed number of iterations, starting from a vector that alternates in sign
+        // since the highest modes of the discretized system are the most oscillatory ones
+        case TimestepMethod::PowerIteration: {
+            const size_t iterations = 30;    // Magic number
+            VectorXd x = VectorXd::NullaryExpr(M.size(), [](Eigen::Index i) { return (i % 2 == 0) ? 1.0 : -1.0; });
+            double lambda = 0.0;
+
+            for(size_t k = 0; k < iterations; ++k) {
+                x.normalize();
+                VectorXd y = S.cwiseProduct(system.get_K().multiply(S.cwiseProduct(x)));
+                lambda = x.dot(y);
+                x = y;
+            }
+
+            return std::sqrt(std::max(lambda, 0.0));
+        }
+
+        default: throw std::logic_error("Unknown timestep method");
+    }
+}
+
+// Gershgorin bound for the highest natural frequency of the subsystem formed by the given element groups and the masses of the whole system
+double DynamicSolver::estimate_max_frequency(const System& system, const std::vector<std::string>& groups) {
+    SystemMatrix K(MatrixStorage::Sparse);
+    system.get_K(groups, K);
+
+    return gershgorin_bound(K, system.get_M());
+}
+
+void DynamicSolver::set_event(const EventFn& event) {
+    this->event = event;
+}
+
+void DynamicSolver::set_adaptive(double factor, TimestepMethod method, const std::vector<std::string>& groups) {
+    this->factor = factor;
+    this->groups = groups;
+    adaptive = true;
+
+    omega_0 = estimate_max_frequency(system, method);
+    omega_groups_0 = groups.empty() ? 0.0 : estimate_max_frequency(system, groups);
+}
+
+// Parameters according to [1] with alpha_m and alpha_f as weights of the previous state
+// [1] J. Chung, G. M. Hulbert: A time integration algorithm for structural dynamics with improved numerical dissipation: The generalized-alpha method, 1993
+void DynamicSolver::set_generalized_alpha(double rho_inf, double factor) {
+    this->factor = factor;
+    implicit = true;
+    alpha_m = (2.0*rho_inf - 1.0)/(rho_inf + 1.0);
+    alpha_f = rho_inf/(rho_inf + 1.0);
+    gamma = 0.5 - alpha_m + alpha_f;
+    beta = 0.25*(1.0 - alpha_m + alpha_f)*(1.0 - alpha_m + alpha_f);
+    dt_factorized = 0.0;
+    implicit_level = 0;
+
+    S = SystemMatrix(system.get_K().storage());
+    a_alg = system.get_a();
+    dt_stable = 0.0;
+}
+
 bool DynamicSolver::step() {
+    // With A = A_0 + B for the system without and with the groups, lambda_max(A) <= lambda_max(A_0) + lambda_max(B) (Weyl's inequality).
+    // Only the growth of the bound of the groups is added, since the initial estimate already includes them.
+    if(adaptive && levels.empty() && !implicit) {
+        double omega_groups = groups.empty() ? 0.0 : estimate_max_frequency(system, groups);
+        double omega = std::sqrt(omega_0*omega_0 + std::max(omega_groups*omega_groups - omega_groups_0*omega_groups_0, 0.0));
+
+        n = std::max(std::ceil(0.5*omega/(f_sample*factor)), 1.0);
+        dt = 1.0/(f_sample*n);
+    }
+
+    // The external forces or the elements may have been changed since the last step
+    std::fill(q_revisions.begin(), q_revisions.end(), std::numeric_limits<size_t>::max());
+
     for(unsigned i = 0; i < n; ++i) {
-        sub_step();
+        if(event) {
+            // State before the substep, to be able to repeat it
+            double t_0 = system.get_t();
+            double dt_p_0 = dt_p;
+            u_0 = system.get_u();
+            v_0 = system.get_v();
+            u_p2_0 = u_p2;
+            a_alg_0 = a_alg;
+
+            double g_0 = event();
+            sub_step(dt);
+            double g_1 = event();
+
+            if(g_1 >= 0.0) {
+                if(g_0 < 0.0) {
+                    system.set_t(t_0);
+                    system.set_u(u_0);
+                    system.set_v(v_0);
+                    u_p2 = u_p2_0;
+                    a_alg = a_alg_0;
+                    dt_p = dt_p_0;
+
+                    sub_step(g_0/(g_0 - g_1)*dt);
+                }
+
+                return false;
+            }
+        }
+        else {
+            sub_step(dt);
+        }
+
         if(stop()) {
             return false;
         }
@@ -51,12 +258,201 @@ bool DynamicSolver::step() {
     return true;
 }
 
-void DynamicSolver::sub_step() {
+// Central difference method for variable timesteps, the velocity is the backward difference of second order.
+// The vectors are updated in place and the buffers of the previous displacements are swapped instead of copied,
+// so that no memory is allocated after the first step.
+void DynamicSolver::sub_step(double h) {
+    if(implicit) {
+        implicit_step(h);
+        return;
+    }
+
+    if(!levels.empty()) {
+        multi_rate_step(0, h);
+        system.set_t(system.get_t() + h);
+        return;
+    }
+
+    const VectorXd& a = system.get_a();    // Acceleration at the current state, evaluated before modifying the displacements
     u_p1 = system.get_u();
 
-    system.set_u(2.0*system.get_u() - u_p2 + dt*dt*system.get_a());
-    system.set_v((1.5*system.get_u() - 2.0*u_p1 + 0.5*u_p2)/dt);
-    system.set_t(system.get_t() + dt);
+    system.mut_u() += h/dt_p*(u_p1 - u_p2);    // Two separate updates, same order of operations as u_p1 + (...) + (...)
+    system.mut_u() += 0.5*h*(h + dt_p)*a;
+    system.mut_v() = (2.0*h + dt_p)/(h*(h + dt_p))*system.get_u() - (h + dt_p)/(h*dt_p)*u_p1 + h/(dt_p*(h + dt_p))*u_p2;
+    system.set_t(system.get_t() + h);
+
+    std::swap(u_p1, u_p2);
+    dt_p = h;
+}
+
+// Generalized-alpha method with the forces averaged over the step like in the HHT method,
+// (1 - alpha_m)*M*a1 + alpha_m*M*a0 + (1 - alpha_f)*(q1 - p) + alpha_f*(q0 - p) = 0,
+// where a and v at the end of the step follow from the displacements u1 by the Newmark relations.
+// The equations are solved for u1 with a modified Newton method that keeps the factorization of the effective
+// stiffness matrix across steps and only refactorizes when the convergence rate degrades or the timestep changes.
+//
+// The accuracy is controlled by the local error estimate (beta - 1/6)*h^2*(a1 - a0) of the displacements [2], relative to
+// the displacement increment. The steps are h/2^k, where the level k is kept across calls. A step that exceeds the tolerance
+// is repeated on the next level, which mostly happens when contacts between string and limb open or close within the step and
+// change the accelerations abruptly. After steps with a small error the level is decreased again where the larger step fits
+// into the grid of the current one. This way the factorization is mostly reused, since the step doesn't alternate between levels.
+// [2] O. C. Zienkiewicz, Y. M. Xie: A simple error estimator and adaptive time stepping procedure for dynamic analysis, 1991
+void DynamicSolver::implicit_step(double h) {
+    const unsigned n_min = 1u << max_level;    // Number of steps on the finest level
+    for(unsigned i = 0; i < n_min; ) {
+        const unsigned m = 1u << (max_level - implicit_level);    // Steps on the finest level per step on the current level
+        const double h_k = h/(1u << implicit_level);
+
+        t_i = system.get_t();
+        u_i = system.get_u();
+        v_i = system.get_v();
+        a_i = a_alg;
+
+        if(implicit_iteration(h_k)) {
+            double error = std::abs(beta - 1.0/6.0)*h_k*h_k*(a_alg - a_i).norm();
+            double limit = tolerance*(system.get_u() - u_i).norm();
+
+            if(error <= limit || implicit_level == max_level) {
+                i += m;
+                if(implicit_level > 0 && error <= 0.25*limit && i % (2*m) == 0) {    // The error of the double step is about four times larger // Magic number
+                    --implicit_level;
+                }
+
+                continue;
+            }
+        }
+
+        // Repeat on the next level if the iterations don't converge or the error is too large. If the iterations still don't converge
+        // on the finest level, use explicit substeps (velocity form of the central difference method) with the stable timestep.
+        system.set_t(t_i);
+        system.set_u(u_i);
+        system.set_v(v_i);
+        a_alg = a_i;
+
+        if(implicit_level < max_level) {
+            ++implicit_level;
+            continue;
+        }
+
+        if(dt_stable == 0.0) {
+            dt_stable = estimate_timestep(system, factor, TimestepMethod::Gershgorin);    // Once, at a state where the iterations failed, usually in contact
+        }
+
+        unsigned substeps = std::ceil(h_k/dt_stable);
+        for(unsigned j = 0; j < substeps; ++j) {
+            system.mut_v() += 0.5*h_k/substeps*system.get_a();
+            system.mut_u() += h_k/substeps*system.get_v();
+            system.mut_v() += 0.5*h_k/substeps*system.get_a();
+        }
+
+        system.set_t(t_i + h_k);
+        a_alg = system.get_a();
+        i += m;
+    }
+}
+
+bool DynamicSolver::implicit_iteration(double h) {
+    const VectorXd& M = system.get_M();
+    const VectorXd u0 = system.get_u();
+    const VectorXd v0 = system.get_v();
+    const VectorXd r0 = system.get_q() - system.get_p();
+
+    auto set_state = [&](const VectorXd& u1) {
+        VectorXd a1 = (u1 - u0 - h*v0)/(beta*h*h) - (0.5/beta - 1.0)*a_alg;
+        system.set_u(u1);
+        system.set_v(v0 + h*((1.0 - gamma)*a_alg + gamma*a1));
+        return a1;
+    };
+
+    VectorXd u1 = u0 + h*v0;    // Predictor with constant velocity
+    double norm_p = 0.0;
+
+    for(unsigned i = 0; i < max_iter; ++i) {
+        VectorXd a1 = set_state(u1);
+        VectorXd r = (1.0 - alpha_m)*M.cwiseProduct(a1) + alpha_m*M.cwiseProduct(a_alg) + (1.0 - alpha_f)*(system.get_q() - system.get_p()) + alpha_f*r0;
+
+        if(dt_factorized != h) {
+            // Derivative of the residual with respect to u1
+            S.resize(system.dofs());
+            S.set_zero();
+            S.add(system.get_K(), 1.0 - alpha_f);
+            S.add(system.get_D(), (1.0 - alpha_f)*gamma/(beta*h));
+            S.add_diagonal((1.0 - alpha_m)/(beta*h*h)*M);
+            S.finalize();
+
+            if(!decomp.factorize(S)) {
+                dt_factorized = 0.0;
+                return false;
+            }
+
+            dt_factorized = h;
+        }
+
+        VectorXd delta_u = decomp.solve(-r);
+        u1 += delta_u;
+
+        double norm = delta_u.norm();
+        if(!std::isfinite(norm)) {
+            return false;
+        }
+
+        if(norm <= epsilon*(u1 - u0).norm()) {
+            a_alg = set_state(u1);
+            system.set_t(system.get_t() + h);
+            return true;
+        }
+
+        if(i > 0 && norm > max_rate*norm_p) {
+            dt_factorized = 0.0;    // Refactorize in the next iteration
+        }
+
+        norm_p = norm;
+    }
+
+    return false;
+}
+
+// Multiple timestep method r-RESPA [1]: The forces of each level are applied as two half impulses ("kicks")
+// around the substeps of the next level, the innermost level updates the displacements. On the innermost level
+// the two half kicks between consecutive substeps are combined into one, so its forces are evaluated once per substep.
+// On the other levels the closing kick of a step and the opening kick of the next one are at the same displacements,
+// so the forces of the closing kick are reused like in velocity Verlet and each level is evaluated once per step.
+// [1] M. Tuckerman, B. J. Berne, G. J. Martyna: Reversible multiple time scale molecular dynamics, 1992
+void DynamicSolver::multi_rate_step(size_t level, double h) {
+    kick(level, 0.5*h);
+
+    size_t next = level + 1;
+    unsigned m = levels[next].substeps;
+
+    if(next + 1 < levels.size()) {
+        for(unsigned i = 0; i < m; ++i) {
+            multi_rate_step(next, h/m);
+        }
+    }
+    else {
+        kick(next, 0.5*h/m);
+        for(unsigned i = 0; i < m; ++i) {
+            system.mut_u() += h/m*system.get_v();
+            kick(next, (i + 1 < m) ? h/m : 0.5*h/m);
+        }
+    }
+
+    kick(level, 0.5*h);
+}
+
+// Applies the forces of the element groups of a level, and the external forces on the first level, for a time h.
+// Within a step, the forces are only evaluated if the displacements changed since the last kick of the level. With damping
+// they are therefore evaluated with the velocities before the closing kick, which is the usual approximation of velocity Verlet.
+void DynamicSolver::kick(size_t level, double h) {
+    VectorXd& q = q_levels[level];
+    if(q_revisions[level] != system.get_u_revision()) {
+        system.get_q(levels[level].groups, q);
+        if(level == 0) {
+            q -= system.get_p();
+        }
+
+        q_revisions[level] = system.get_u_revision();
+    }
 
-    u_p2 = u_p1;
+    system.mut_v() -= h*q.cwiseProduct(system.get_M_inv());
 }
@@ -1,28 +1,129 @@
 #pragma once
+#include "solver/fem/LinearSolver.hpp"
+#include "solver/fem/SystemMatrix.hpp"
 #include "solver/numerics/EigenTypes.hpp"
 #include <functional>
+#include <string>
+#include <vector>
 
 class System;
 
-// Central difference method
+// Methods for estimating the highest natural frequency omega_max of the undamped system, which limits the stable timestep
+enum class TimestepMethod {
+    Eigenvalues,       // Exact, dense eigenvalue decomposition of M^-1*K, O(n^3)
+    ElementBound,      // Maximum of the highest frequencies of the single elements with a partition of the masses, upper bound
+    Gershgorin,        // Gershgorin circle bound on the eigenvalues of M^-1*K, upper bound
+    PowerIteration,    // Few steps of power iteration on M^-1*K, lower bound that is only accurate for a well separated omega_max
+    Automatic          // Eigenvalues for small systems, where they are cheap, Gershgorin for large ones
+};
+
+// Time integration methods of the dynamic solver
+enum class IntegrationMethod {
+    CentralDifference,    // Explicit, stable for timesteps dt < 2/omega_max
+    GeneralizedAlpha      // Implicit, unconditionally stable with numerical damping of the highest frequencies
+};
+
+// Element groups that are integrated with a smaller timestep than the groups of the previous level
+struct SubcyclingLevel {
+    std::vector<std::string> groups;
+    unsigned substeps;    // Number of steps per step of the previous level
+};
+
+// Central difference method or, optionally, the implicit generalized-alpha method
+//
+// Optionally with subcycling: The groups of elements are assigned to levels with decreasing timesteps, where each level
+// performs a fixed number of substeps per step of the previous one. The first level contains the remaining groups
+// and uses the timestep dt. This way stiff but cheap elements like the string don't limit the timestep of the whole system.
 class DynamicSolver
 {
 public:
     using StopFn = std::function<bool()>;
+    using EventFn = std::function<double()>;
+
+    DynamicSolver(System& system, double dt, double f_sample, const StopFn& stop, const std::vector<SubcyclingLevel>& subcycling = {});
+    static double estimate_timestep(const System& system, double factor, TimestepMethod method = TimestepMethod::Automatic);
+    static double estimate_max_frequency(const System& system, TimestepMethod method);
+    static double estimate_max_frequency(const System& system, const std::vector<std::string>& groups);
+
+    // Stops the simulation where the event function crosses zero from below. The crossing is interpolated linearly
+    // within the substep that detects it and the substep is repeated with the corresponding shorter length.
+    // If the event function is already non-negative at the start, the simulation stops after the first substep.
+    void set_event(const EventFn& event);
+
+    // Adapts the timestep at every step to the stiffness of the given element groups, whose stiffness changes abruptly
+    // during the simulation (like contacts). The highest frequency is estimated once for the whole system with the given method
+    // and increased by the growth of the Gershgorin bound of the groups, which is cheap to evaluate as long as they are small.
+    // The substeps divide the sampling interval. Not used with subcycling, where the timestep of each level is fixed.
+    void set_adaptive(double factor, TimestepMethod method, const std::vector<std::string>& groups = {});
+
+    // Uses the generalized-alpha method with the spectral radius rho_inf in [0, 1] at infinite frequency instead of
+    // central differences. The timestep is then only limited by accuracy, steps with a large local error are subdivided.
+    // Steps that don't converge are replaced by explicit substeps with the safety factor for the stable timestep.
+    // Not combined with subcycling or adaptive timesteps.
+    void set_generalized_alpha(double rho_inf, double factor);
 
-    DynamicSolver(System& system, double dt, double f_sample, const StopFn& stop);
-    static double estimate_timestep(const System& system, double factor);
     bool step();
 
 private:
     System& system;
     StopFn stop;
+    EventFn event;
+
+    double dt;          // Substep size
+    double dt_p;        // Size of the previous substep
+    unsigned n;         // Number of substeps per step
+    double f_sample;
+
+    double factor = 0.0;    // Safety factor for the stable timestep with adaptive timesteps and in the fallback of the implicit method
 
-    double dt;     // Substep size
-    unsigned n;    // Number of substeps per step
+    // Adaptive timesteps
+    bool adaptive = false;
+    std::vector<std::string> groups;    // Element groups whose stiffness is tracked
+    double omega_0;                     // Initial estimate of the highest frequency of the system
+    double omega_groups_0;              // Initial Gershgorin bound of the groups
 
     VectorXd u_p2;
     VectorXd u_p1;
 
-    void sub_step();
+    // State before the current substep, for repeating it at an event
+    VectorXd u_0;
+    VectorXd v_0;
+    VectorXd u_p2_0;
+    VectorXd a_alg_0;
+
+    std::vector<SubcyclingLevel> levels;
+    std::vector<VectorXd> q_levels;       // Forces of each level at the last kick
+    std::vector<size_t> q_revisions;      // Revisions of the displacements at which they were evaluated
+
+    // Generalized-alpha method
+    bool implicit = false;
+    double alpha_m;
+    double alpha_f;
+    double beta;
+    double gamma;
+    double dt_factorized;    // Timestep of the current factorization, zero if there is none
+    double dt_stable;        // Stable timestep of the central difference method for steps that don't converge, zero until needed
+    unsigned implicit_level; // Number of times the current step is halved
+
+    const unsigned max_iter = 25;       // Magic number
+    const double epsilon = 1e-8;        // Newton increment relative to the displacement step // Magic number
+    const double max_rate = 0.25;       // Maximum ratio of successive increments before refactorizing // Magic number
+    const unsigned max_level = 6;       // Maximum number of times a step is halved // Magic number
+    const double tolerance = 1e-2;      // Local error relative to the displacement step // Magic number
+
+    LinearSolver decomp;
+    SystemMatrix S;    // Effective stiffness matrix
+    VectorXd a_alg;    // Algorithmic acceleration
+
+    // State before the current implicit step, for repeating it
+    double t_i;
+    VectorXd u_i;
+    VectorXd v_i;
+    VectorXd a_i;
+
+    void sub_step(double h);
+    void implicit_step(double h);
+    bool implicit_iteration(double h);
+    void multi_rate_step(size_t level, double h);
+    void kick(size_t level, double h);
 };
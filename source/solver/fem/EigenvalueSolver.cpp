@@ -1,7 +1,8 @@
 #include "EigenvalueSolver.hpp"
 #include "solver/fem/System.hpp"
+#include <Eigen/Eigenvalues>
 #include <algorithm>
-#include <optional>
+#include <random>
 
 ModeInfo::ModeInfo(std::complex<double> lambda) {
     omega = std::hypot(lambda.real(), lambda.imag());
@@ -14,61 +15,202 @@ EigenvalueSolver::EigenvalueSolver(const System& system)
 
 }
 
-auto EigenvalueSolver::compute_eigenvalues() {
-    int n = system.dofs();
-    A.conservativeResize(2*n, 2*n);
-    B.conservativeResize(2*n, 2*n);
+// Dominant eigenvalue of C^-1 with C^-1*r = [-K^-1*(M*r2 + D*r1); r1]
+ModeInfo EigenvalueSolver::compute_minimum_frequency() {
+    size_t n = system.dofs();
+    if(!stiffness.factorize(system.get_K())) {
+        throw std::runtime_error("Failed to compute eigenvalues of the system, the stiffness matrix is singular");
+    }
 
-    A << MatrixXd::Zero(n, n), system.get_K(),
-         system.get_K(), system.get_D();
+    auto op = [&](const VectorXd& r) {
+        VectorXd w(2*n);
+        w.head(n) = -stiffness.solve(system.get_M().cwiseProduct(r.tail(n)) + system.get_D().multiply(r.head(n)));
+        w.tail(n) = r.head(n);
+        return w;
+    };
 
-    B << system.get_K(), MatrixXd::Zero(n, n),
-         MatrixXd::Zero(n, n), -system.get_M().asDiagonal().toDenseMatrix();
+    return ModeInfo(1.0/dominant_eigenvalue(op, 2*n, 1e-10));    // Magic number
+}
 
-    solver.compute(A, B, Eigen::DecompositionOptions::EigenvaluesOnly);
-    if(solver.info() != Eigen::Success) {
-        throw std::runtime_error("Failed to compute eigenvalues of the system. Solver info: " + std::to_string(solver.info()));
+// Dominant eigenvalue of C, transformed to mass-normalized coordinates x = M^(-1/2)*z for better conditioning:
+// C*z = [z2; -S*(K*S*z1 + D*S*z2)] with S = M^(-1/2)
+ModeInfo EigenvalueSolver::compute_maximum_frequency() {
+    size_t n = system.dofs();
+    if((system.get_M().array() <= 0.0).any()) {
+        throw std::runtime_error("Failed to compute eigenvalues of the system, the mass matrix is singular");
     }
 
-    return solver.eigenvalues();
+    VectorXd S = system.get_M().cwiseSqrt().cwiseInverse();
+    auto op = [&](const VectorXd& z) {
+        VectorXd w(2*n);
+        w.head(n) = z.tail(n);
+        w.tail(n) = -S.cwiseProduct(system.get_K().multiply(S.cwiseProduct(z.head(n))) + system.get_D().multiply(S.cwiseProduct(z.tail(n))));
+        return w;
+    };
+
+    return ModeInfo(dominant_eigenvalue(op, 2*n, 1e-10));    // Magic number
 }
 
-// Todo: Implement with filter + minimum
-ModeInfo EigenvalueSolver::compute_minimum_frequency() {
-    std::optional<ModeInfo> result = std::nullopt;
-    auto eigenvalues = compute_eigenvalues();
-    for(int i = 0; i < eigenvalues.size(); ++i) {
-        if(eigenvalues[i].imag() > 0.0) {
-            ModeInfo temp(eigenvalues[i]);
-            if(!result || temp.omega < result->omega) {
-                result = temp;
-            }
+// Subspace iteration [1] with twice the number of requested modes, each iteration applies K^-1*M to the subspace
+// and performs a Rayleigh-Ritz projection. The modes are converged when their frequencies don't change anymore.
+// [1] https://en.wikipedia.org/wiki/Eigenvalue_algorithm#Iterative_algorithms
+void EigenvalueSolver::compute_undamped_modes(size_t k, VectorXd& omega, MatrixXd& modes) {
+    size_t n = system.dofs();
+    size_t p = std::min(2*k, n);
+    k = std::min(k, n);
+
+    if(!stiffness.factorize(system.get_K())) {
+        throw std::runtime_error("Failed to compute eigenvalues of the system, the stiffness matrix is singular");
+    }
+
+    std::mt19937 generator(0);
+    std::uniform_real_distribution<double> distribution(-1.0, 1.0);
+    MatrixXd X(n, p);
+    for(size_t j = 0; j < p; ++j) {
+        for(size_t i = 0; i < n; ++i) {
+            X(i, j) = distribution(generator);
         }
     }
 
-    if(!result) {
-        throw std::runtime_error("Failed to find eigenvalue with lowest natural frequency");
+    VectorXd lambda = VectorXd::Zero(k);
+    for(size_t iteration = 0; iteration < 100; ++iteration) {    // Magic number
+        MatrixXd Y(n, p);
+        MatrixXd KY(n, p);
+        for(size_t j = 0; j < p; ++j) {
+            Y.col(j) = stiffness.solve(system.get_M().cwiseProduct(X.col(j)));
+            KY.col(j) = system.get_K().multiply(Y.col(j));
+        }
+
+        MatrixXd K_r = Y.transpose()*KY;
+        MatrixXd M_r = Y.transpose()*system.get_M().asDiagonal()*Y;
+        Eigen::GeneralizedSelfAdjointEigenSolver<MatrixXd> ritz(0.5*(K_r + K_r.transpose()), 0.5*(M_r + M_r.transpose()));
+        if(ritz.info() != Eigen::Success) {
+            throw std::runtime_error("Failed to compute eigenvalues of the system. Solver info: " + std::to_string(ritz.info()));
+        }
+
+        X = Y*ritz.eigenvectors();    // Mass-normalized, eigenvalues in increasing order
+        bool converged = ((ritz.eigenvalues().head(k) - lambda).array().abs() <= 1e-8*ritz.eigenvalues().head(k).array().abs()).all();    // Magic number, close to the accuracy of the projection
+        lambda = ritz.eigenvalues().head(k);
+
+        if(converged) {
+            omega = lambda.cwiseMax(0.0).cwiseSqrt();
+            modes = X.leftCols(k);
+            return;
+        }
     }
 
-    return *result;
+    throw std::runtime_error("Failed to compute eigenvalues of the system, the subspace iteration did not converge");
 }
 
-// Todo: Implement with filter + maximum
-ModeInfo EigenvalueSolver::compute_maximum_frequency() {
-    std::optional<ModeInfo> result = std::nullopt;
-    auto eigenvalues = compute_eigenvalues();
-    for(int i = 0; i < eigenvalues.size(); ++i) {
-        if(eigenvalues[i].imag() > 0.0) {
-            ModeInfo temp(eigenvalues[i]);
-            if(!result || temp.omega > result->omega) {
-                result = temp;
-            }
+// Eigenvalues of the state space matrix [0, I; -M^-1*K, -M^-1*D]
+ModeInfo EigenvalueSolver::compute_minimum_frequency(const MatrixXd& K, const MatrixXd& D, const MatrixXd& M) {
+    size_t n = K.rows();
+    MatrixXd C(2*n, 2*n);
+    C.topLeftCorner(n, n).setZero();
+    C.topRightCorner(n, n).setIdentity();
+    C.bottomLeftCorner(n, n) = -M.ldlt().solve(K);
+    C.bottomRightCorner(n, n) = -M.ldlt().solve(D);
+
+    Eigen::EigenSolver<MatrixXd> solver(C, false);
+    if(solver.info() != Eigen::Success) {
+        throw std::runtime_error("Failed to compute eigenvalues of the system. Solver info: " + std::to_string(solver.info()));
+    }
+
+    int index = -1;
+    for(int i = 0; i < solver.eigenvalues().size(); ++i) {
+        if(solver.eigenvalues()[i].imag() > 0.0 && (index == -1 || std::abs(solver.eigenvalues()[i]) < std::abs(solver.eigenvalues()[index]))) {
+            index = i;
         }
     }
 
-    if(!result) {
-        throw std::runtime_error("Failed to find eigenvalue with highest natural frequency");
+    if(index == -1) {
+        throw std::runtime_error("Failed to find eigenvalue with lowest natural frequency");
+    }
+
+    return ModeInfo(solver.eigenvalues()[index]);
+}
+
+// Eigenvalue with nonzero imaginary part and maximum magnitude of a real operator of size n, computed with the
+// Arnoldi method and explicit restarts from the current Ritz vector. The eigenvalue is converged when the residual
+// of the Ritz pair is smaller than the tolerance relative to the magnitude of the eigenvalue.
+std::complex<double> EigenvalueSolver::dominant_eigenvalue(const Operator& op, size_t n, double tolerance) {
+    const size_t m = std::min(n, size_t(40));    // Maximum dimension of the Krylov subspace // Magic number
+    const size_t restarts = 50;                  // Magic number
+
+    MatrixXd V(n, m + 1);
+    MatrixXd H(m + 1, m);
+
+    // Pseudo-random start vector with fixed seed for reproducible results
+    std::mt19937 generator(0);
+    std::uniform_real_distribution<double> distribution(-1.0, 1.0);
+    VectorXd v(n);
+    for(size_t i = 0; i < n; ++i) {
+        v(i) = distribution(generator);
+    }
+
+    for(size_t restart = 0; restart <= restarts; ++restart) {
+        V.col(0) = v/v.norm();
+        H.setZero();
+
+        for(size_t k = 0; k < m; ++k) {
+            // Orthogonalize the new Krylov vector against the previous ones, twice for numerical stability
+            VectorXd w = op(V.col(k));
+            for(int pass = 0; pass < 2; ++pass) {
+                VectorXd h = V.leftCols(k + 1).transpose()*w;
+                w -= V.leftCols(k + 1)*h;
+                H.col(k).head(k + 1) += h;
+            }
+
+            H(k + 1, k) = w.norm();
+            bool invariant = H(k + 1, k) <= 1e-14*H.col(k).head(k + 1).norm();    // Krylov subspace is invariant, Ritz values are exact // Magic number
+            if(!invariant) {
+                V.col(k + 1) = w/H(k + 1, k);
+            }
+
+            // Check the Ritz values every few steps and at the end of the cycle
+            bool last = invariant || (k + 1 == m);
+            if(!last && (k + 1) % 5 != 0) {    // Magic number
+                continue;
+            }
+
+            Eigen::EigenSolver<MatrixXd> ritz(H.topLeftCorner(k + 1, k + 1));
+            if(ritz.info() != Eigen::Success) {
+                throw std::runtime_error("Failed to compute eigenvalues of the system. Solver info: " + std::to_string(ritz.info()));
+            }
+
+            int index = -1;
+            for(int i = 0; i < ritz.eigenvalues().size(); ++i) {
+                if(ritz.eigenvalues()[i].imag() != 0.0 && (index == -1 || std::abs(ritz.eigenvalues()[i]) > std::abs(ritz.eigenvalues()[index]))) {
+                    index = i;
+                }
+            }
+
+            if(index == -1) {
+                if(invariant) {
+                    throw std::runtime_error("Failed to find a complex eigenvalue of the system");
+                }
+                if(last) {
+                    v = V.col(k + 1);
+                }
+                continue;
+            }
+
+            std::complex<double> theta = ritz.eigenvalues()[index];
+            Eigen::VectorXcd y = ritz.eigenvectors().col(index).normalized();
+            double residual = invariant ? 0.0 : H(k + 1, k)*std::abs(y(k));
+
+            if(residual <= tolerance*std::abs(theta)) {
+                return theta;
+            }
+
+            if(last) {
+                // Restart from the Ritz vector, real and imaginary part together contain both of the conjugate eigenvectors
+                Eigen::VectorXcd x = V.leftCols(k + 1).cast<std::complex<double>>()*y;
+                v = x.real() + x.imag();
+                break;
+            }
+        }
     }
 
-    return *result;
+    throw std::runtime_error("Failed to compute eigenvalues of the system, the Arnoldi method did not converge");
 }
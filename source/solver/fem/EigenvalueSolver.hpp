@@ -1,7 +1,8 @@
 #pragma once
+#include "solver/fem/LinearSolver.hpp"
 #include "solver/numerics/EigenTypes.hpp"
-#include <Eigen/Eigenvalues>
 #include <complex>
+#include <functional>
 
 class System;
 
@@ -16,17 +17,31 @@ struct ModeInfo {
     ModeInfo(std::complex<double> lambda);
 };
 
+// Computes single modes of the quadratic eigenvalue problem (lambda^2*M + lambda*D + K)*x = 0 of the system.
+//
+// The modes are eigenvalues of the state space operator C = [0, I; -M^-1*K, -M^-1*D], which is never formed.
+// Instead the Arnoldi method [1] only uses products of C or its inverse with vectors, which need products with K, D and M
+// and for the inverse a factorization of K. The lowest mode is the dominant eigenvalue of C^-1 (shift-invert at zero),
+// the highest one is the dominant eigenvalue of C itself. In the latter case the Arnoldi method acts as an accelerated
+// power iteration that also converges to the complex conjugate pair of dominant eigenvalues.
+// [1] https://en.wikipedia.org/wiki/Arnoldi_iteration
 class EigenvalueSolver {
 public:
     EigenvalueSolver(const System& system);
     ModeInfo compute_minimum_frequency();
     ModeInfo compute_maximum_frequency();
 
+    // Lowest k modes of the undamped system K*x = omega^2*M*x, mass-normalized
+    void compute_undamped_modes(size_t k, VectorXd& omega, MatrixXd& modes);
+
+    // Lowest mode of a small system with dense matrices
+    static ModeInfo compute_minimum_frequency(const MatrixXd& K, const MatrixXd& D, const MatrixXd& M);
+
 private:
+    using Operator = std::function<VectorXd(const VectorXd&)>;
+
     const System& system;
-    Eigen::GeneralizedEigenSolver<MatrixXd> solver;
-    MatrixXd A;
-    MatrixXd B;
+    LinearSolver stiffness;
 
-    auto compute_eigenvalues();
+    std::complex<double> dominant_eigenvalue(const Operator& op, size_t n, double tolerance);
 };
@@ -1,7 +1,13 @@
 #include "Element.hpp"
+#include "System.hpp"
 
 Element::Element(System& system)
     : system(system)
 {
 
 }
+
+void Element::modified()
+{
+    system.mut_elements().modified();
+}
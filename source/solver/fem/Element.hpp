@@ -1,4 +1,6 @@
 #pragma once
+#include "Node.hpp"
+#include <vector>
 
 class System;
 
@@ -16,6 +18,12 @@ public:
     virtual double get_potential_energy() const = 0;
     virtual double get_kinetic_energy() const = 0;
 
+    // DOFs that the element adds contributions to
+    virtual std::vector<Dof> get_dofs() const = 0;
+
 protected:
     System& system;
+
+    // Reports a change of the element to the element container of the system, to be called by the setters of the element
+    void modified();
 };
@@ -0,0 +1,216 @@
+#include "ElementContainer.hpp"
+#include <algorithm>
+#include <typeinfo>
+
+void ElementContainer::set_batching(bool enabled) {
+    batching = enabled;
+    batched = false;
+}
+
+// Number of threads for assembling internal forces, stiffness and damping, one for serial assembly
+void ElementContainer::set_parallel(unsigned threads, bool deterministic) {
+    pool = (threads > 1) ? std::make_unique<ThreadPool>(threads) : nullptr;
+    this->deterministic = deterministic;
+    batched = false;
+}
+
+// Whether the elements are evaluated by colour instead of in the order of the batches
+bool ElementContainer::colored() const {
+    return pool != nullptr || deterministic;
+}
+
+// Processes the colours in order and the elements of each colour in parallel
+template<typename F>
+void ElementContainer::for_each_colored(const F& function) const {
+    for(auto& color: colors) {
+        if(pool == nullptr || color.size() == 1) {
+            for(auto e: color)
+                function(e);
+        }
+        else {
+            pool->run(color.size(), deterministic, [&](size_t i){ function(color[i]); });
+        }
+    }
+}
+
+void ElementContainer::add_masses() const {
+    update_batches();
+    for(auto& group: groups) {
+        group.second.beams.add_masses();
+        group.second.bars.add_masses();
+        group.second.masses.add_masses();
+
+        for(auto e: group.second.others)
+            e->add_masses();
+    }
+}
+
+void ElementContainer::add_internal_forces() const {
+    update_batches();
+    if(colored()) {
+        for_each_colored([](const Element* e){ e->add_internal_forces(); });
+        return;
+    }
+
+    for(auto& group: groups) {
+        group.second.beams.add_internal_forces();
+        group.second.bars.add_internal_forces();
+        group.second.masses.add_internal_forces();
+
+        for(auto e: group.second.others)
+            e->add_internal_forces();
+    }
+}
+
+void ElementContainer::add_tangent_stiffness() const {
+    update_batches();
+    if(colored()) {
+        for_each_colored([](const Element* e){ e->add_tangent_stiffness(); });
+        return;
+    }
+
+    for(auto& group: groups) {
+        group.second.beams.add_tangent_stiffness();
+
+        for(auto e: group.second.unbatched_stiffness)
+            e->add_tangent_stiffness();
+    }
+}
+
+void ElementContainer::add_tangent_damping() const {
+    update_batches();
+    if(colored()) {
+        for_each_colored([](const Element* e){ e->add_tangent_damping(); });
+        return;
+    }
+
+    for(auto e: elements)
+        e->add_tangent_damping();
+}
+
+std::vector<std::string> ElementContainer::get_keys() const {
+    std::vector<std::string> keys;
+    for(auto& group: groups)
+        keys.push_back(group.first);
+
+    return keys;
+}
+
+void ElementContainer::add_internal_forces(const std::string& key) const {
+    update_batches();
+    const Group& group = groups[key];
+
+    group.beams.add_internal_forces();
+    group.bars.add_internal_forces();
+    group.masses.add_internal_forces();
+
+    for(auto e: group.others)
+        e->add_internal_forces();
+}
+
+void ElementContainer::add_tangent_stiffness(const std::string& key) const {
+    update_batches();
+    const Group& group = groups[key];
+
+    group.beams.add_tangent_stiffness();
+
+    for(auto e: group.unbatched_stiffness)
+        e->add_tangent_stiffness();
+}
+
+double ElementContainer::get_kinetic_energy(const std::string& key) const {
+    update_batches();
+    const Group& group = groups[key];
+
+    double e_kin = group.beams.get_kinetic_energy()
+                 + group.bars.get_kinetic_energy()
+                 + group.masses.get_kinetic_energy();
+
+    for(auto e: group.others)
+        e_kin += e->get_kinetic_energy();
+
+    return e_kin;
+}
+
+double ElementContainer::get_potential_energy(const std::string& key) const {
+    update_batches();
+    const Group& group = groups[key];
+
+    double e_pot = group.beams.get_potential_energy()
+                 + group.bars.get_potential_energy()
+                 + group.masses.get_potential_energy();
+
+    for(auto e: group.others)
+        e_pot += e->get_potential_energy();
+
+    return e_pot;
+}
+
+// Sorts the elements of each group into the batches of their exact type, or the individually evaluated ones.
+// For parallel assembly the elements are also coloured greedily, each one getting the first colour that
+// none of the elements sharing a DOF with it has been given.
+void ElementContainer::update_batches() const {
+    if(batched) {
+        return;
+    }
+
+    for(auto& group: groups) {
+        Group& g = group.second;
+        g.beams.clear();
+        g.bars.clear();
+        g.masses.clear();
+        g.others.clear();
+        g.unbatched_stiffness.clear();
+
+        for(auto e: g.elements) {
+            if(batching && typeid(*e) == typeid(BeamElement)) {
+                g.beams.add(static_cast<const BeamElement&>(*e));
+                continue;
+            }
+
+            g.unbatched_stiffness.push_back(e);
+
+            if(batching && typeid(*e) == typeid(BarElement)) {
+                g.bars.add(static_cast<const BarElement&>(*e));
+            }
+            else if(batching && typeid(*e) == typeid(MassElement)) {
+                g.masses.add(static_cast<const MassElement&>(*e));
+            }
+            else {
+                g.others.push_back(e);
+            }
+        }
+    }
+
+    colors.clear();
+    if(colored()) {
+        std::vector<std::vector<bool>> used;    // Used DOFs by colour, active DOF i at 2*i, fixed DOF i at 2*i + 1
+        for(auto e: elements) {
+            std::vector<size_t> keys;
+            for(const Dof& dof: e->get_dofs()) {
+                keys.push_back(2*dof.index + (dof.active ? 0 : 1));
+            }
+
+            auto is_free = [&](const std::vector<bool>& dofs) {
+                return std::none_of(keys.begin(), keys.end(), [&](size_t k){ return k < dofs.size() && dofs[k]; });
+            };
+
+            size_t c = std::find_if(used.begin(), used.end(), is_free) - used.begin();
+            if(c == used.size()) {
+                used.emplace_back();
+                colors.emplace_back();
+            }
+
+            for(size_t k: keys) {
+                if(k >= used[c].size()) {
+                    used[c].resize(k + 1, false);
+                }
+                used[c][k] = true;
+            }
+
+            colors[c].push_back(e);
+        }
+    }
+
+    batched = true;
+}
@@ -1,8 +1,13 @@
 #pragma once
 #include "Element.hpp"
+#include "ThreadPool.hpp"
+#include "solver/fem/elements/BeamElement.hpp"
+#include "solver/fem/elements/BarElement.hpp"
+#include "solver/fem/elements/MassElement.hpp"
 #include <boost/range/iterator_range.hpp>
 #include <boost/iterator/transform_iterator.hpp>
 #include <vector>
+#include <memory>
 #include <map>
 
 // Transform iterator that performs a dynamic cast for every element. Adapted from stackoverflow,
@@ -32,14 +37,29 @@ public:
 };
 
 // The element container stores groups of elements that are identified by keys (string)
+//
+// With batching enabled (default), the beam, bar and mass elements of each group are additionally kept in batches
+// that store their DOFs and parameters in contiguous arrays (structure of arrays). Masses, internal forces and energies
+// are then evaluated by the batched kernels of the element types instead of a virtual call per element.
+// The tangent stiffness is batched for the beams only, the other elements add theirs individually.
+// The batches are copies of the elements and are rebuilt lazily after elements were added or modified. The elements report
+// changes of their parameters or DOFs to the container themselves (Element::modified), so references to them stay usable.
+//
+// With parallel assembly, the internal forces, tangent stiffness and tangent damping are evaluated by a pool of threads.
+// The elements are coloured such that no two elements of the same colour share a DOF. The colours are processed one after
+// another and the elements within a colour in parallel, which needs no locking since they write to different entries.
+// Every entry therefore receives its contributions in the order of the colours, regardless of the number of threads.
+// The deterministic flag also uses this order for a single thread, so the results are bitwise identical for any number of threads.
+// Without it, a single thread uses the batched evaluation, which is faster but sums in a different order.
 
 class ElementContainer {
 public:
     template<typename ElementType = Element>
     void add(ElementType element, const std::string& key = "") {
         Element* ptr = new ElementType(element);
-        groups[key].push_back(ptr);
+        groups[key].elements.push_back(ptr);
         elements.push_back(ptr);
+        batched = false;
     }
 
     ~ElementContainer() {
@@ -76,55 +96,89 @@ public:
 
     template<class ElementType>
     boost::iterator_range<iterator<ElementType>> group(const std::string& key) {
-        return {groups[key].begin(), groups[key].end()};
+        return {groups[key].elements.begin(), groups[key].elements.end()};
     }
 
     template<class ElementType>
     boost::iterator_range<const_iterator<ElementType>> group(const std::string& key) const {
-        return {groups[key].begin(), groups[key].end()};
+        return {groups[key].elements.begin(), groups[key].elements.end()};
     }
 
     // Single element access
 
     template<class ElementType>
     ElementType& front(const std::string& key) {
-        return dynamic_cast<ElementType&>(*groups[key].front());
+        return dynamic_cast<ElementType&>(*groups[key].elements.front());
     }
 
     template<class ElementType>
     const ElementType& front(const std::string& key) const {
-        return dynamic_cast<const ElementType&>(*groups[key].front());
+        return dynamic_cast<const ElementType&>(*groups[key].elements.front());
     }
 
     template<class ElementType>
     ElementType& back(const std::string& key) {
-        return dynamic_cast<ElementType&>(*groups[key].back());
+        return dynamic_cast<ElementType&>(*groups[key].elements.back());
     }
 
     template<class ElementType>
     const ElementType& back(const std::string& key) const {
-        return dynamic_cast<const ElementType&>(*groups[key].back());
+        return dynamic_cast<const ElementType&>(*groups[key].elements.back());
     }
 
-    // Summing energies of groups
+    // Called by elements after a change of their parameters or DOFs, rebuilds the batches before the next evaluation
+    void modified() {
+        batched = false;
+    }
 
-    double get_kinetic_energy(const std::string& key) const {
-        double e_kin = 0.0;
-        for(auto e: groups[key])
-            e_kin += e->get_kinetic_energy();
+    // Evaluating all elements
 
-        return e_kin;
-    }
+    void set_batching(bool enabled);
+    void set_parallel(unsigned threads, bool deterministic = false);
 
-    double get_potential_energy(const std::string& key) const {
-        double e_pot = 0.0;
-        for(auto e: groups[key])
-            e_pot += e->get_potential_energy();
+    void add_masses() const;
+    void add_internal_forces() const;
+    void add_tangent_stiffness() const;
+    void add_tangent_damping() const;
 
-        return e_pot;
-    }
+    // Evaluating groups of elements
+
+    std::vector<std::string> get_keys() const;
+    void add_internal_forces(const std::string& key) const;
+    void add_tangent_stiffness(const std::string& key) const;
+
+    // Summing energies of groups
+
+    double get_kinetic_energy(const std::string& key) const;
+    double get_potential_energy(const std::string& key) const;
 
 private:
+    struct Group {
+        std::vector<Element*> elements;
+
+        // Batched copies of the elements and the remaining ones that are evaluated individually
+        BeamElement::Batch beams;
+        BarElement::Batch bars;
+        MassElement::Batch masses;
+        std::vector<Element*> others;
+
+        // Elements whose tangent stiffness isn't evaluated by a batch, only the beams have a batched stiffness kernel
+        std::vector<Element*> unbatched_stiffness;
+    };
+
+    void update_batches() const;
+    bool colored() const;
+
+    template<typename F>
+    void for_each_colored(const F& function) const;
+
     mutable std::vector<Element*> elements;
-    mutable std::map<std::string, std::vector<Element*>> groups;
+    mutable std::map<std::string, Group> groups;
+    mutable std::vector<std::vector<Element*>> colors;    // Elements by colour, no shared DOFs within a colour
+
+    std::unique_ptr<ThreadPool> pool;
+    bool deterministic = false;
+
+    bool batching = true;
+    mutable bool batched = false;
 };
@@ -0,0 +1,133 @@
+#include "LinearSolver.hpp"
+#include <stdexcept>
+
+LinearSolver::LinearSolver(Factorization method)
+    : requested(method),
+      selected(method),
+      pattern_size(0),
+      pattern_revision(0),
+      bandwidth(0),
+      analyzed(false)
+{
+
+}
+
+Factorization LinearSolver::method() const {
+    return selected;
+}
+
+bool LinearSolver::factorize(const SystemMatrix& A) {
+    selected = requested;
+    if(selected == Factorization::Automatic) {
+        selected = (A.storage() == MatrixStorage::Dense) ? Factorization::DenseLDLT : Factorization::SparseLDLT;
+    }
+
+    switch(selected) {
+        case Factorization::DenseLDLT: return factorize_dense(A);
+        case Factorization::BandedLDLT: return factorize_banded(A);
+        case Factorization::SparseLDLT: return factorize_sparse(A);
+        default: throw std::logic_error("Unknown factorization method");
+    }
+}
+
+VectorXd LinearSolver::solve(const VectorXd& b) const {
+    switch(selected) {
+        case Factorization::DenseLDLT: return dense_decomp.solve(b);
+        case Factorization::SparseLDLT: return sparse_decomp.solve(b);
+        case Factorization::BandedLDLT: {
+            VectorXd x = b;
+            banded_decomp.solve(x);
+            return x;
+        }
+        default: throw std::logic_error("Unknown factorization method");
+    }
+}
+
+bool LinearSolver::factorize_dense(const SystemMatrix& A) {
+    if(A.storage() == MatrixStorage::Dense) {
+        dense_decomp.compute(A.dense());
+    }
+    else {
+        dense_decomp.compute(A.to_dense());
+    }
+
+    return dense_decomp.info() == Eigen::Success;
+}
+
+bool LinearSolver::factorize_banded(const SystemMatrix& A) {
+    size_t n = A.size();
+
+    if(A.storage() == MatrixStorage::Dense) {
+        // Bandwidth of a dense matrix: Distance of the outermost nonzero entry in the lower triangle to the diagonal
+        const MatrixXd& dense = A.dense();
+        bandwidth = 0;
+        for(size_t j = 0; j < n; ++j) {
+            for(size_t i = n; i-- > j + bandwidth + 1;) {
+                if(dense(i, j) != 0.0) {
+                    bandwidth = i - j;
+                    break;
+                }
+            }
+        }
+
+        banded_decomp.resize(n, bandwidth);
+        for(size_t j = 0; j < n; ++j) {
+            for(size_t i = j; i <= std::min(n - 1, j + bandwidth); ++i) {
+                banded_decomp.at(i, j) = dense(i, j);
+            }
+        }
+    }
+    else {
+        const SparseMatrix& sparse = A.sparse();
+        if(pattern_changed(A)) {
+            bandwidth = 0;
+            for(int j = 0; j < sparse.outerSize(); ++j) {
+                for(SparseMatrix::InnerIterator it(sparse, j); it; ++it) {
+                    if(it.row() > it.col()) {
+                        bandwidth = std::max(bandwidth, size_t(it.row() - it.col()));
+                    }
+                }
+            }
+            banded_decomp.resize(n, bandwidth);
+        }
+        else {
+            banded_decomp.set_zero();
+        }
+
+        for(int j = 0; j < sparse.outerSize(); ++j) {
+            for(SparseMatrix::InnerIterator it(sparse, j); it; ++it) {
+                if(it.row() >= it.col()) {
+                    banded_decomp.at(it.row(), it.col()) = it.value();
+                }
+            }
+        }
+    }
+
+    return banded_decomp.factorize();
+}
+
+bool LinearSolver::factorize_sparse(const SystemMatrix& A) {
+    if(A.storage() == MatrixStorage::Dense) {
+        sparse_copy = A.dense().sparseView();
+        sparse_decomp.compute(sparse_copy);
+        return sparse_decomp.info() == Eigen::Success;
+    }
+
+    if(pattern_changed(A)) {
+        sparse_decomp.analyzePattern(A.sparse());
+    }
+
+    sparse_decomp.factorize(A.sparse());
+    return sparse_decomp.info() == Eigen::Success;
+}
+
+// Returns whether the structure of the matrix has changed since the last call and updates the stored state
+bool LinearSolver::pattern_changed(const SystemMatrix& A) {
+    bool changed = !analyzed || A.size() != pattern_size || A.pattern_revision() != pattern_revision;
+
+    analyzed = true;
+    pattern_size = A.size();
+    pattern_revision = A.pattern_revision();
+
+    return changed;
+}
@@ -0,0 +1,46 @@
+#pragma once
+#include "solver/fem/SystemMatrix.hpp"
+#include "solver/numerics/BandedLDLT.hpp"
+#include "solver/numerics/EigenTypes.hpp"
+#include <Eigen/Cholesky>
+#include <Eigen/SparseCholesky>
+
+// Methods for factorizing the symmetric system matrices
+enum class Factorization {
+    Automatic,     // Dense or sparse LDLT, depending on the storage of the matrix
+    DenseLDLT,     // Dense LDLT with pivoting
+    BandedLDLT,    // LDLT without pivoting on the band of the matrix, the bandwidth depends on the numbering of the dofs
+    SparseLDLT     // Simplicial sparse LDLT, the symbolic analysis is only repeated if the sparsity pattern changes
+};
+
+// Solves linear systems A*x = b with a symmetric system matrix A, which is factorized once by factorize(A)
+// and can then be used for multiple solutions. Structural information like the bandwidth or the sparse symbolic
+// analysis is cached and only updated if the size or the pattern revision of the matrix change.
+class LinearSolver {
+public:
+    LinearSolver(Factorization method = Factorization::Automatic);
+
+    bool factorize(const SystemMatrix& A);
+    VectorXd solve(const VectorXd& b) const;
+
+    Factorization method() const;
+
+private:
+    Factorization requested;
+    Factorization selected;
+
+    Eigen::LDLT<MatrixXd> dense_decomp;
+    Eigen::SimplicialLDLT<SparseMatrix> sparse_decomp;
+    BandedLDLT banded_decomp;
+
+    SparseMatrix sparse_copy;    // Sparse copy of a dense matrix for the sparse method
+    size_t pattern_size;         // Size of the matrix at the last structural update
+    size_t pattern_revision;     // Pattern revision of the matrix at the last structural update
+    size_t bandwidth;
+    bool analyzed;
+
+    bool factorize_dense(const SystemMatrix& A);
+    bool factorize_banded(const SystemMatrix& A);
+    bool factorize_sparse(const SystemMatrix& A);
+    bool pattern_changed(const SystemMatrix& A);
+};
@@ -0,0 +1,75 @@
+#include "PathStates.hpp"
+#include "solver/fem/System.hpp"
+#include "solver/numerics/FindInterval.hpp"
+#include "solver/numerics/Lagrange.hpp"
+#include <stdexcept>
+
+void PathStates::add_state(double s, const System& system) {
+    if(!states.empty() && s < states.back().s) {
+        throw std::invalid_argument("Path parameter must be increasing");
+    }
+
+    if(!states.empty() && s == states.back().s) {
+        states.pop_back();
+    }
+
+    states.push_back({s, system.get_u(), system.get_p()});
+}
+
+size_t PathStates::size() const {
+    return states.size();
+}
+
+bool PathStates::predict(double s, unsigned order, System& system) const {
+    if(states.empty()) {
+        return false;
+    }
+
+    size_t n = std::min<size_t>(order + 1, states.size());
+    apply(states.size() - n, states.size(), s, system);
+
+    return true;
+}
+
+bool PathStates::restore(System& system) const {
+    if(states.empty()) {
+        return false;
+    }
+
+    system.set_u(states.back().u);
+    system.set_p(states.back().p);
+
+    return true;
+}
+
+void PathStates::interpolate(double s, unsigned order, System& system) const {
+    if(states.empty()) {
+        throw std::logic_error("No states to interpolate from");
+    }
+
+    // Select the order + 1 states around the interval [s_i, s_i+1] that contains s, shifted inwards at the ends of the path
+    size_t n = std::min<size_t>(order + 1, states.size());
+    if(n > 1) {
+        index = find_interval(states, [](const State& state){ return state.s; }, s, index);
+    }
+
+    size_t first = (index > (n - 1)/2) ? index - (n - 1)/2 : 0;
+    first = std::min(first, states.size() - n);
+
+    apply(first, first + n, s, system);
+}
+
+// Lagrange polynomial through the states first, ..., last - 1
+void PathStates::apply(size_t first, size_t last, double s, System& system) const {
+    VectorXd u = VectorXd::Zero(states.back().u.size());
+    VectorXd p = VectorXd::Zero(states.back().p.size());
+
+    for(size_t k = first; k < last; ++k) {
+        double w = lagrange_basis(states, [](const State& state){ return state.s; }, first, last, k, s);
+        u += w*states[k].u;
+        p += w*states[k].p;
+    }
+
+    system.set_u(u);
+    system.set_p(p);
+}
@@ -0,0 +1,31 @@
+#pragma once
+#include "solver/numerics/EigenTypes.hpp"
+#include <vector>
+
+class System;
+
+// Equilibrium states of a system (displacements and external forces) along a path that is parametrized by an
+// increasing scalar, like the draw length. New states are predicted by polynomial extrapolation of the last ones,
+// states in between by piecewise polynomial interpolation. Both use order + 1 states, or all of them as long as there are fewer.
+// Order 0 repeats the nearest state, order 1 is linear (secant), order 2 quadratic and so on.
+class PathStates {
+public:
+    void add_state(double s, const System& system);    // Replaces the last state if it has the same parameter
+    size_t size() const;
+
+    bool predict(double s, unsigned order, System& system) const;        // Applies the extrapolated state to the system, returns false if there is no state yet
+    bool restore(System& system) const;                                  // Applies the last state to the system, returns false if there is no state yet
+    void interpolate(double s, unsigned order, System& system) const;    // Applies the interpolated state to the system, requires at least one state
+
+private:
+    struct State {
+        double s;
+        VectorXd u;
+        VectorXd p;
+    };
+
+    std::vector<State> states;
+    mutable size_t index = 0;    // Interval index of the last interpolation
+
+    void apply(size_t first, size_t last, double s, System& system) const;
+};
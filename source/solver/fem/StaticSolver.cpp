@@ -1,9 +1,14 @@
 #include "StaticSolver.hpp"
 #include "solver/fem/System.hpp"
 #include "solver/numerics/Optimization.hpp"
+#include <limits>
+#include <stdexcept>
 
-StaticSolver::StaticSolver(System& system)
+StaticSolver::StaticSolver(System& system, const StaticSolverOptions& options)
     : system(system),
+      options(options),
+      decomp(options.factorization),
+      factorized(false),
       delta_q(system.dofs()),
       delta_u(system.dofs()),
       alpha(system.dofs()),
@@ -14,52 +19,177 @@ StaticSolver::StaticSolver(System& system)
 }
 
 StaticSolver::Info StaticSolver::solve() {
+    Info info{Info::NoConvergence, 0, 0, 0, 1};
+
     double lambda = 1.0;
+    double residual_prev = std::numeric_limits<double>::infinity();
+    bool refactorize = (options.strategy == NewtonStrategy::Full) || !factorized;
+
     for(unsigned i = 0; i < max_iter; ++i) {
-        decomp.compute(system.get_K());
-        if(decomp.info() != Eigen::Success)
-            return {Info::DecompFailed, i+1};
+        info.iterations = i+1;
+
+        if(refactorize) {
+            factorized = decomp.factorize(system.get_K());
+            info.factorizations += 1;
+
+            bfgs_s.clear();
+            bfgs_y.clear();
+            bfgs_rho.clear();
+
+            if(!factorized) {
+                info.outcome = Info::DecompFailed;
+                return info;
+            }
+        }
 
+        // With modified Newton the inverse doesn't change between factorizations, so beta can be reused
         delta_q = system.get_q() - lambda*system.get_p();
-        alpha = -decomp.solve(delta_q);
-        beta = decomp.solve(system.get_p());
+        alpha = -apply_inverse(delta_q, info);
+        if(refactorize || i == 0 || options.strategy != NewtonStrategy::Modified) {
+            beta = apply_inverse(system.get_p(), info);
+        }
 
         // Evaluate constraint
         constraint(system.get_u(), lambda, c, dcdl, dcdu);
-        double delta_l;
-        if((dcdl + dcdu.transpose()*beta) != 0) {    // Todo: Epsilon
-            delta_l = -(c + dcdu.transpose()*alpha)/(dcdl + dcdu.transpose()*beta);
-        }
-        else {
-            delta_l = 0.0;
-        }
+        double delta_l = get_load_increment(c);
 
         delta_u = alpha + delta_l*beta;
 
         // Line search
+        double c_trial, dcdl_trial;
+        VectorXd dcdu_trial;
         VectorXd u_start = system.get_u();
+        VectorXd q_start = system.get_q();
         double l_start = lambda;
         auto f = [&](double eta) {
             system.set_u(u_start + eta*delta_u);
             lambda = l_start + eta*delta_l;
+            info.evaluations += 1;
             return std::abs(delta_u.transpose()*(system.get_q() - lambda*system.get_p()));
         };
 
-        golden_section_search(f, 0.0, 1.0, 1e-2, 50);
+        switch(options.line_search) {
+            case LineSearch::None:
+                f(1.0);
+                break;
+
+            case LineSearch::Armijo: {
+                // Merit function like the convergence criterion, including the residual of the constraint
+                auto g = [&](double eta) {
+                    double r = f(eta);
+                    constraint(system.get_u(), lambda, c_trial, dcdl_trial, dcdu_trial);
+                    return r + std::abs(delta_l*c_trial);
+                };
+
+                backtracking_search(g, std::abs(delta_u.transpose()*delta_q) + std::abs(delta_l*c), armijo_c, armijo_factor, armijo_iter);
+                break;
+            }
+
+            case LineSearch::GoldenSection:
+                golden_section_search(f, 0.0, 1.0, 1e-2, 50);
+                break;
+        }
 
         // If convergence...
-        if(std::abs(delta_u.transpose()*delta_q) + std::abs(delta_l*c) < epsilon) {    // Todo: Better convergence criterion
+        double residual = std::abs(delta_u.transpose()*delta_q) + std::abs(delta_l*c);
+        if(residual < epsilon) {    // Todo: Better convergence criterion
             // ...apply load factor to the system and return
             system.set_p(lambda*system.get_p());
-            return {Info::Success, i+1};
+            info.outcome = Info::Success;
+            return info;
+        }
+
+        // Decide whether to keep the current factorization for the next iteration
+        if(options.strategy != NewtonStrategy::Full) {
+            refactorize = (residual > max_rate*residual_prev);
+        }
+
+        // Add a BFGS update from the actual step if it satisfies the curvature condition y^T*s > 0
+        if(options.strategy == NewtonStrategy::BFGS && !refactorize) {
+            VectorXd s = system.get_u() - u_start;
+            VectorXd y = system.get_q() - q_start;
+            double ys = y.dot(s);
+
+            if(ys > std::numeric_limits<double>::epsilon()*y.norm()*s.norm()) {
+                bfgs_s.push_back(s);
+                bfgs_y.push_back(y);
+                bfgs_rho.push_back(1.0/ys);
+            }
+
+            refactorize = (bfgs_s.size() > max_updates);
+        }
+
+        residual_prev = residual;
+    }
+
+    return info;
+}
+
+VectorXd StaticSolver::get_sensitivity(const VectorXd& dqdx) {
+    // Reuse the factorization of the last iteration, which is close to the converged state
+    if(!factorized) {
+        factorized = decomp.factorize(system.get_K());
+        bfgs_s.clear();
+        bfgs_y.clear();
+        bfgs_rho.clear();
+
+        if(!factorized) {
+            throw std::runtime_error("Static solver: Failed to factorize the tangent stiffness matrix");
         }
     }
 
-    return {Info::NoConvergence, max_iter};
+    // Same as a Newton step from an equilibrium state with lambda = 1 and dqdx in place of the residual
+    Info info{Info::Success, 0, 0, 0, 0};
+    alpha = -apply_inverse(dqdx, info);
+    beta = apply_inverse(system.get_p(), info);
+
+    constraint(system.get_u(), 1.0, c, dcdl, dcdu);
+    return alpha + get_load_increment(0.0)*beta;
+}
+
+// Change of the load factor for the displacement change alpha + delta_l*beta that satisfies the linearized constraint,
+// with the constraint c and its derivatives dcdl, dcdu at the current state. If the constraint doesn't depend on the load factor
+// within numerical precision, i.e. the denominator is zero relative to its terms, the load factor is kept constant.
+double StaticSolver::get_load_increment(double c) const {
+    double dcdb = dcdu.dot(beta);
+    double denominator = dcdl + dcdb;
+
+    if(std::abs(denominator) <= std::numeric_limits<double>::epsilon()*(std::abs(dcdl) + std::abs(dcdb))) {
+        return 0.0;
+    }
+
+    return -(c + dcdu.dot(alpha))/denominator;
+}
+
+// Applies the inverse of the factorized tangent stiffness matrix, including the BFGS updates, to the right hand side.
+// Uses the two-loop recursion as described in [1], with the factorized matrix as the initial approximation.
+// [1] https://en.wikipedia.org/wiki/Limited-memory_BFGS
+VectorXd StaticSolver::apply_inverse(const VectorXd& rhs, Info& info) {
+    info.solves += 1;
+    if(bfgs_s.empty()) {
+        return decomp.solve(rhs);
+    }
+
+    size_t m = bfgs_s.size();
+    bfgs_a.resize(m);
+
+    VectorXd r = rhs;
+    for(size_t k = m; k-- > 0;) {
+        bfgs_a[k] = bfgs_rho[k]*bfgs_s[k].dot(r);
+        r -= bfgs_a[k]*bfgs_y[k];
+    }
+
+    r = decomp.solve(r);
+    for(size_t k = 0; k < m; ++k) {
+        double b = bfgs_rho[k]*bfgs_y[k].dot(r);
+        r += (bfgs_a[k] - b)*bfgs_s[k];
+    }
+
+    return r;
 }
 
-StaticSolverLC::StaticSolverLC(System& system)
-    : StaticSolver(system)
+StaticSolverLC::StaticSolverLC(System& system, const StaticSolverOptions& options)
+    : StaticSolver(system, options)
 {
 
 }
@@ -74,8 +204,8 @@ void StaticSolverLC::constraint(const VectorXd& u, double lambda, double& c, dou
     dcdu.setZero();
 }
 
-StaticSolverDC::StaticSolverDC(System& system, Dof dof)
-    : StaticSolver(system),
+StaticSolverDC::StaticSolverDC(System& system, Dof dof, const StaticSolverOptions& options)
+    : StaticSolver(system, options),
       dof(dof),
       target(0.0),
       e_dof(VectorXd::Unit(system.dofs(), dof.index))
@@ -2,10 +2,31 @@
 #include "Node.hpp"
 #include "solver/numerics/Optimization.hpp"
 #include "solver/numerics/EigenTypes.hpp"
-#include <Eigen/Cholesky>
+#include "solver/fem/LinearSolver.hpp"
+#include <vector>
 
 class System;
 
+// Strategies for updating the tangent stiffness matrix during the iterations of the static solver
+enum class NewtonStrategy {
+    Full,        // Factorize the tangent stiffness matrix in every iteration
+    Modified,    // Reuse the last factorization, also across calls of solve(), until the convergence rate degrades
+    BFGS         // Like Modified, but with BFGS rank-two updates of the inverse between factorizations
+};
+
+// Line search methods for scaling the Newton steps of the static solver
+enum class LineSearch {
+    None,            // Always take the full step
+    Armijo,          // Backtracking, starting with the full step, until the residual decreases sufficiently
+    GoldenSection    // Minimize the residual along the step by golden section search
+};
+
+struct StaticSolverOptions {
+    Factorization factorization = Factorization::Automatic;
+    NewtonStrategy strategy = NewtonStrategy::Full;
+    LineSearch line_search = LineSearch::Armijo;
+};
+
 // Todo: Make constraint function a member with templated type instead of using inheritance.
 class StaticSolver {
 public:
@@ -13,9 +34,17 @@ public:
     struct Info {
         enum { Success, DecompFailed, NoConvergence } outcome;
         unsigned iterations;
+        unsigned factorizations;    // Number of factorizations of the tangent stiffness matrix
+        unsigned solves;            // Number of linear solutions with the (updated) factorization
+        unsigned evaluations;       // Number of residual evaluations (internal forces at new displacements), including the line search
     };
 
-    StaticSolver(System& system);
+    StaticSolver(System& system, const StaticSolverOptions& options);
+
+    // Derivative of the equilibrium displacements with respect to a parameter of the system, like the length of an element,
+    // after a successful call of solve(). Takes the derivative of the internal forces with respect to the parameter at constant
+    // displacements and keeps the constraint satisfied by adjusting the load factor. Reuses the last factorization of the solver.
+    VectorXd get_sensitivity(const VectorXd& dqdx);
 
 protected:
     Info solve();
@@ -23,11 +52,25 @@ protected:
 
 private:
     System& system;
+    StaticSolverOptions options;
+
+    const unsigned max_iter = 150;      // Todo: Magic number
+    const double epsilon = 1e-5;        // Todo: Magic number
+    const double max_rate = 0.5;        // Maximum ratio of successive residuals before refactorizing (Modified, BFGS) // Magic number
+    const unsigned max_updates = 20;    // Maximum number of BFGS updates before refactorizing // Magic number
+    const double armijo_c = 1e-4;       // Sufficient decrease parameter of the Armijo line search // Magic number
+    const double armijo_factor = 0.5;   // Step reduction factor of the Armijo line search // Magic number
+    const unsigned armijo_iter = 10;    // Maximum number of trial steps of the Armijo line search // Magic number
 
-    const unsigned max_iter = 150;    // Todo: Magic number
-    const double epsilon = 1e-5;      // Todo: Magic number
+    LinearSolver decomp;
+    bool factorized;
+
+    // BFGS updates: Displacement steps s, changes of the internal forces y and 1/(y^T*s)
+    std::vector<VectorXd> bfgs_s;
+    std::vector<VectorXd> bfgs_y;
+    std::vector<double> bfgs_rho;
+    VectorXd bfgs_a;
 
-    Eigen::LDLT<MatrixXd> decomp;
     VectorXd delta_q;
     VectorXd delta_u;
     VectorXd alpha;
@@ -36,12 +79,15 @@ private:
     double c;
     double dcdl;
     VectorXd dcdu;
+
+    VectorXd apply_inverse(const VectorXd& rhs, Info& info);
+    double get_load_increment(double c) const;
 };
 
 class StaticSolverLC: public StaticSolver
 {
 public:
-    StaticSolverLC(System& system);
+    StaticSolverLC(System& system, const StaticSolverOptions& options = {});
     Info solve();
 
 protected:
@@ -51,7 +97,7 @@ protected:
 class StaticSolverDC: public StaticSolver
 {
 public:
-    StaticSolverDC(System& system, Dof dof);
+    StaticSolverDC(System& system, Dof dof, const StaticSolverOptions& options = {});
     Info solve(double displacement);
 
 protected:
@@ -1,71 +1,80 @@
 #include "System.hpp"
+#include <algorithm>
 
-System::System()
-    : t(0.0), n_a(0), n_f(0)
+System::System(MatrixStorage storage)
+    : t(0.0), n_a(0), n_f(0), K_a(SystemMatrix(storage)), D_a(SystemMatrix(storage))
 {
-    auto update_a = [&]()
-    {
-        a_a.mut() = M_a.get().asDiagonal().inverse()*(p_a.get() - q_a.get());
-    };
+    a_a.depends_on(M_inv, p_a, q_a);
+    a_a.on_update<System, &System::update_a>(this);
 
-    auto update_q = [&]()
-    {
-        q_a.mut().conservativeResize(u_a.get().size());
-        q_f.mut().conservativeResize(u_f.get().size());
-        q_a.mut().setZero();
-        q_f.mut().setZero();
+    q_a.depends_on(elements, n_a, u_a, u_f, v_a);
+    q_a.on_update<System, &System::update_q>(this);
 
-        for(auto& e: elements.get())
-            e.add_internal_forces();
+    q_f.depends_on(elements, n_f, u_a, u_f, v_a);
+    q_f.on_update<System, &System::update_q>(this);
 
-        q_a.set_valid(true);
-        q_f.set_valid(true);
-    };
+    M_a.depends_on(elements, n_a);
+    M_a.on_update<System, &System::update_M>(this);
 
-    auto update_M = [&]()
-    {
-        M_a.mut().conservativeResize(dofs());
-        M_a.mut().setZero();
+    M_inv.depends_on(M_a);
+    M_inv.on_update<System, &System::update_M_inv>(this);
 
-        for(auto& e: elements.get())
-            e.add_masses();
-    };
+    K_a.depends_on(elements, n_a, u_a);
+    K_a.on_update<System, &System::update_K>(this);
 
-    auto update_K = [&]()
-    {
-        K_a.mut().conservativeResize(dofs(), dofs());
-        K_a.mut().setZero();
+    D_a.depends_on(elements, n_a, u_a, v_a);
+    D_a.on_update<System, &System::update_D>(this);
+}
 
-        for(auto& e: elements.get())
-            e.add_tangent_stiffness();
-    };
+void System::update_a() const
+{
+    a_a.mut() = M_inv.get().cwiseProduct(p_a.get() - q_a.get());
+}
 
-    auto update_D = [&]()
-    {
-        D_a.mut().conservativeResize(dofs(), dofs());
-        D_a.mut().setZero();
+void System::update_q() const
+{
+    q_a.mut().resize(u_a.get().size());
+    q_f.mut().resize(u_f.get().size());
+    q_a.mut().setZero();
+    q_f.mut().setZero();
 
-        for(auto& e: elements.get())
-            e.add_tangent_damping();
-    };
+    elements.get().add_internal_forces();
 
-    a_a.depends_on(M_a, p_a, q_a);
-    a_a.on_update(update_a);
+    q_a.set_valid(true);
+    q_f.set_valid(true);
+}
 
-    q_a.depends_on(elements, n_a, u_a, u_f, v_a);
-    q_a.on_update(update_q);
+void System::update_M() const
+{
+    M_a.mut().resize(dofs());
+    M_a.mut().setZero();
 
-    q_f.depends_on(elements, n_f, u_a, u_f, v_a);
-    q_f.on_update(update_q);
+    elements.get().add_masses();
+}
 
-    M_a.depends_on(elements, n_a);
-    M_a.on_update(update_M);
+void System::update_M_inv() const
+{
+    M_inv.mut() = M_a.get().cwiseInverse();
+}
 
-    K_a.depends_on(elements, n_a, u_a);
-    K_a.on_update(update_K);
+void System::update_K() const
+{
+    K_a.mut().resize(dofs());
+    K_a.mut().set_zero();
 
-    D_a.depends_on(elements, n_a, u_a, v_a);
-    D_a.on_update(update_D);
+    elements.get().add_tangent_stiffness();
+
+    K_a.mut().finalize();
+}
+
+void System::update_D() const
+{
+    D_a.mut().resize(dofs());
+    D_a.mut().set_zero();
+
+    elements.get().add_tangent_damping();
+
+    D_a.mut().finalize();
 }
 
 Node System::create_node(std::array<bool, 3> active, std::array<double, 3> u)
@@ -140,6 +149,11 @@ const VectorXd& System::get_u() const
     return u_a.get();
 }
 
+size_t System::get_u_revision() const
+{
+    return u_a.revision() + u_f.revision();    // Both are only ever incremented
+}
+
 const VectorXd& System::get_v() const
 {
     return v_a.get();
@@ -165,16 +179,98 @@ const VectorXd& System::get_M() const
     return M_a.get();
 }
 
-const MatrixXd& System::get_K() const
+const VectorXd& System::get_M_inv() const
+{
+    return M_inv.get();
+}
+
+const SystemMatrix& System::get_K() const
 {
     return K_a.get();
 }
 
-const MatrixXd& System::get_D() const
+const SystemMatrix& System::get_D() const
 {
     return D_a.get();
 }
 
+// Tangent stiffness matrix of a single element, restricted to the active DOFs of the element.
+// Their indices into the active DOFs of the system are returned in indices.
+MatrixXd System::get_element_K(const Element& element, std::vector<size_t>& indices) const
+{
+    indices.clear();
+    for(const Dof& dof: element.get_dofs())
+    {
+        if(dof.active)
+            indices.push_back(dof.index);
+    }
+
+    std::sort(indices.begin(), indices.end());
+    indices.erase(std::unique(indices.begin(), indices.end()), indices.end());
+
+    MatrixXd K_e = MatrixXd::Zero(indices.size(), indices.size());
+    K_element = &K_e;
+    K_element_indices = &indices;
+    try
+    {
+        element.add_tangent_stiffness();
+    }
+    catch(...)
+    {
+        K_element = nullptr;
+        K_element_indices = nullptr;
+        throw;
+    }
+
+    K_element = nullptr;
+    K_element_indices = nullptr;
+
+    return K_e;
+}
+
+// Internal forces (active DOFs) of the elements in the given groups alone, not cached
+void System::get_q(const std::vector<std::string>& groups, VectorXd& q) const
+{
+    q.resize(dofs());
+    q.setZero();
+
+    q_partial = &q;
+    try
+    {
+        for(auto& key: groups)
+            elements.get().add_internal_forces(key);
+    }
+    catch(...)
+    {
+        q_partial = nullptr;
+        throw;
+    }
+
+    q_partial = nullptr;
+}
+
+// Tangent stiffness matrix of the elements in the given groups alone, not cached
+void System::get_K(const std::vector<std::string>& groups, SystemMatrix& K) const
+{
+    K.resize(dofs());
+    K.set_zero();
+
+    K_partial = &K;
+    try
+    {
+        for(auto& key: groups)
+            elements.get().add_tangent_stiffness(key);
+    }
+    catch(...)
+    {
+        K_partial = nullptr;
+        throw;
+    }
+
+    K_partial = nullptr;
+    K.finalize();
+}
+
 double System::get_u(Dof dof) const
 {
     return get_by_dof(&u_a.get(), &u_f.get(), dof);
@@ -210,6 +306,16 @@ void System::set_v(const Ref<const VectorXd>& v)
     v_a.mut() = v;
 }
 
+VectorXd& System::mut_u()
+{
+    return u_a.mut();
+}
+
+VectorXd& System::mut_v()
+{
+    return v_a.mut();
+}
+
 void System::set_p(const Ref<const VectorXd>& p)
 {
     p_a.mut() = p;
@@ -1,6 +1,7 @@
 #pragma once
 #include "Node.hpp"
 #include "DofView.hpp"
+#include "SystemMatrix.hpp"
 #include "Element.hpp"
 #include "ElementContainer.hpp"
 #include "Dependency.hpp"
@@ -23,11 +24,27 @@ private:
     mutable Dependent<VectorXd> q_a;    // Internal forces (active)
     mutable Dependent<VectorXd> q_f;    // Internal forces (fixed)
     mutable Dependent<VectorXd> M_a;    // Diagonal masses (active)
-    mutable Dependent<MatrixXd> K_a;    // Tangent stiffness matrix (active)
-    mutable Dependent<MatrixXd> D_a;    // Tangent damping matrix (active)
+    mutable Dependent<VectorXd> M_inv;  // Inverse of the diagonal masses (active)
+    mutable Dependent<SystemMatrix> K_a;    // Tangent stiffness matrix (active)
+    mutable Dependent<SystemMatrix> D_a;    // Tangent damping matrix (active)
+
+    // Replace q_a and K_a as targets of add_q() and add_K() while evaluating only a part of the elements
+    mutable VectorXd* q_partial = nullptr;
+    mutable SystemMatrix* K_partial = nullptr;
+
+    // Replaces K_a as target of add_K() while evaluating a single element, a dense block over the element's active DOFs
+    mutable MatrixXd* K_element = nullptr;
+    mutable const std::vector<size_t>* K_element_indices = nullptr;
+
+    void update_a() const;
+    void update_q() const;
+    void update_M() const;
+    void update_M_inv() const;
+    void update_K() const;
+    void update_D() const;
 
 public:
-    System();
+    System(MatrixStorage storage = MatrixStorage::Dense);
 
     // Nodes and elements
 
@@ -54,8 +71,16 @@ public:
     const VectorXd& get_a() const;
     const VectorXd& get_q() const;
     const VectorXd& get_M() const;
-    const MatrixXd& get_K() const;
-    const MatrixXd& get_D() const;
+    const VectorXd& get_M_inv() const;
+    const SystemMatrix& get_K() const;
+    const SystemMatrix& get_D() const;
+    MatrixXd get_element_K(const Element& element, std::vector<size_t>& indices) const;
+
+    // Changes whenever the displacements are modified, for caching values that only depend on them
+    size_t get_u_revision() const;
+
+    void get_q(const std::vector<std::string>& groups, VectorXd& q) const;
+    void get_K(const std::vector<std::string>& groups, SystemMatrix& K) const;
 
     double get_u(Dof dof) const;
     double get_v(Dof dof) const;
@@ -64,106 +89,91 @@ public:
     double get_q(Dof dof) const;
 
     template<size_t N>
-    Vector<N> get_u(const std::array<Dof, N>& dofs) const;
+    Vector<N> get_u(const DofMap<N>& dofs) const;
     template<size_t N>
-    Vector<N> get_v(const std::array<Dof, N>& dofs) const;
+    Vector<N> get_v(const DofMap<N>& dofs) const;
     template<size_t N>
-    Vector<N> get_p(const std::array<Dof, N>& dofs) const;
+    Vector<N> get_p(const DofMap<N>& dofs) const;
     template<size_t N>
-    Vector<N> get_a(const std::array<Dof, N>& dofs) const;
+    Vector<N> get_a(const DofMap<N>& dofs) const;
     template<size_t N>
-    Vector<N> get_q(const std::array<Dof, N>& dofs) const;
+    Vector<N> get_q(const DofMap<N>& dofs) const;
 
     void set_u(const Ref<const VectorXd>& u);
     void set_v(const Ref<const VectorXd>& v);
+
+    // Write access to the displacements and velocities for updating them in place, without temporaries
+    VectorXd& mut_u();
+    VectorXd& mut_v();
     void set_p(const Ref<const VectorXd>& p);
     void set_p(Dof dof, double p);
 
     template<size_t N, class T>
-    void add_q(const std::array<Dof, N>& dofs, const T& q);
+    void add_q(const DofMap<N>& dofs, const T& q);
     template<size_t N, class T>
-    void add_M(const std::array<Dof, N>& dofs, const T& M);
+    void add_M(const DofMap<N>& dofs, const T& M);
     template<size_t N, class T>
-    void add_K(const std::array<Dof, N>& dofs, const T& K);
+    void add_K(const DofMap<N>& dofs, const T& K);
     template<size_t N, class T>
-    void add_D(const std::array<Dof, N>& dofs, const T& D);
+    void add_D(const DofMap<N>& dofs, const T& D);
 };
 
 template<size_t N>
-Vector<N> System::get_u(const std::array<Dof, N>& dofs) const
+Vector<N> System::get_u(const DofMap<N>& dofs) const
 {
-    Vector<N> result;
-    for(size_t i = 0; i < N; ++i) {
-        result(i) = get_u(dofs[i]);
-    }
-
-    return result;
+    return dofs.gather(u_a.get(), &u_f.get());
 }
 
 template<size_t N>
-Vector<N> System::get_v(const std::array<Dof, N>& dofs) const
+Vector<N> System::get_v(const DofMap<N>& dofs) const
 {
-    Vector<N> result;
-    for(size_t i = 0; i < N; ++i) {
-        result(i) = get_v(dofs[i]);
-    }
-
-    return result;
+    return dofs.gather(v_a.get(), nullptr);
 }
 
 template<size_t N>
-Vector<N> System::get_p(const std::array<Dof, N>& dofs) const
+Vector<N> System::get_p(const DofMap<N>& dofs) const
 {
-    Vector<N> result;
-    for(size_t i = 0; i < N; ++i) {
-        result(i) = get_p(dofs[i]);
-    }
-
-    return result;
+    return dofs.gather(p_a.get(), nullptr);
 }
 
 template<size_t N>
-Vector<N> System::get_a(const std::array<Dof, N>& dofs) const
+Vector<N> System::get_a(const DofMap<N>& dofs) const
 {
-    Vector<N> result;
-    for(size_t i = 0; i < N; ++i) {
-        result(i) = get_a(dofs[i]);
-    }
-
-    return result;
+    return dofs.gather(a_a.get(), nullptr);
 }
 
 template<size_t N>
-Vector<N> System::get_q(const std::array<Dof, N>& dofs) const
+Vector<N> System::get_q(const DofMap<N>& dofs) const
 {
-    Vector<N> result;
-    for(size_t i = 0; i < N; ++i) {
-        result(i) = get_q(dofs[i]);
-    }
-
-    return result;
+    return dofs.gather(q_a.get(), &q_f.get());
 }
 
 template<size_t N, class T>
-void System::add_q(const std::array<Dof, N>& dofs, const T& q)
+void System::add_q(const DofMap<N>& dofs, const T& q)
 {
-    add_by_dof(&q_a.mut(), &q_f.mut(), dofs, q);
+    if(q_partial)
+        dofs.scatter_add(*q_partial, nullptr, q);
+    else
+        dofs.scatter_add(q_a.mut_in_update(), &q_f.mut_in_update(), q);
 }
 
 template<size_t N, class T>
-void System::add_M(const std::array<Dof, N>& dofs, const T& M)
+void System::add_M(const DofMap<N>& dofs, const T& M)
 {
-    add_by_dof(&M_a.mut(), nullptr, dofs, M);
+    dofs.scatter_add(M_a.mut_in_update(), nullptr, M);
 }
 
 template<size_t N, class T>
-void System::add_K(const std::array<Dof, N>& dofs, const T& K)
+void System::add_K(const DofMap<N>& dofs, const T& K)
 {
-    add_by_dof(&K_a.mut(), dofs, K);
+    if(K_element)
+        dofs.scatter_add(*K_element, *K_element_indices, K);
+    else
+        dofs.scatter_add(K_partial ? *K_partial : K_a.mut_in_update(), K);
 }
 
 template<size_t N, class T>
-void System::add_D(const std::array<Dof, N>& dofs, const T& D)
+void System::add_D(const DofMap<N>& dofs, const T& D)
 {
-    add_by_dof(&D_a.mut(), dofs, D);
+    dofs.scatter_add(D_a.mut_in_update(), D);
 }
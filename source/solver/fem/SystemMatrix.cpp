@@ -0,0 +1,172 @@
+#include "SystemMatrix.hpp"
+#include <cassert>
+#include <limits>
+#include <mutex>
+#include <tuple>
+
+SystemMatrix::SystemMatrix(MatrixStorage storage)
+    : format(storage),
+      revision(0)
+{
+
+}
+
+MatrixStorage SystemMatrix::storage() const {
+    return format;
+}
+
+size_t SystemMatrix::size() const {
+    return (format == MatrixStorage::Dense) ? dense_matrix.rows() : sparse_matrix.rows();
+}
+
+size_t SystemMatrix::pattern_revision() const {
+    return revision;
+}
+
+void SystemMatrix::resize(size_t n) {
+    if(n == size()) {
+        return;
+    }
+
+    if(format == MatrixStorage::Dense) {
+        dense_matrix.conservativeResize(n, n);
+    }
+    else {
+        sparse_matrix.resize(n, n);    // Discards the sparsity pattern
+        pending.clear();
+    }
+
+    ++revision;
+}
+
+void SystemMatrix::set_zero() {
+    if(format == MatrixStorage::Dense) {
+        dense_matrix.setZero();
+    }
+    else {
+        sparse_matrix.coeffs().setZero();
+        pending.clear();
+    }
+}
+
+// Entries outside of the pattern are rare, so a single lock shared by all matrices is enough
+void SystemMatrix::add_pending(size_t i, size_t j, double value) {
+    static std::mutex mutex;
+    std::lock_guard<std::mutex> lock(mutex);
+    pending.emplace_back(i, j, value);
+}
+
+void SystemMatrix::add(const SystemMatrix& A, double factor) {
+    assert(A.size() == size());
+    if(format == MatrixStorage::Dense && A.format == MatrixStorage::Dense) {
+        dense_matrix += factor*A.dense_matrix;
+    }
+    else if(A.format == MatrixStorage::Dense) {
+        for(int j = 0; j < A.dense_matrix.cols(); ++j) {
+            for(int i = 0; i < A.dense_matrix.rows(); ++i) {
+                add(i, j, factor*A.dense_matrix(i, j));
+            }
+        }
+    }
+    else {
+        for(int j = 0; j < A.sparse_matrix.outerSize(); ++j) {
+            for(SparseMatrix::InnerIterator it(A.sparse_matrix, j); it; ++it) {
+                add(it.row(), it.col(), factor*it.value());
+            }
+        }
+    }
+}
+
+void SystemMatrix::add_diagonal(const VectorXd& d) {
+    assert(size_t(d.size()) == size());
+    for(int i = 0; i < d.size(); ++i) {
+        add(i, i, d(i));
+    }
+}
+
+// Merges the entries that were added outside of the current sparsity pattern into the matrix.
+// Existing entries are kept, even if their value is zero.
+void SystemMatrix::finalize() {
+    if(pending.empty()) {
+        return;
+    }
+
+    // Sorting makes the summation order of duplicate entries independent of the order of the add() calls
+    std::sort(pending.begin(), pending.end(), [](const auto& a, const auto& b) {
+        return std::make_tuple(a.col(), a.row(), a.value()) < std::make_tuple(b.col(), b.row(), b.value());
+    });
+
+    pending.reserve(pending.size() + sparse_matrix.nonZeros());
+    for(int j = 0; j < sparse_matrix.outerSize(); ++j) {
+        for(SparseMatrix::InnerIterator it(sparse_matrix, j); it; ++it) {
+            pending.emplace_back(it.row(), it.col(), it.value());
+        }
+    }
+
+    sparse_matrix.setFromTriplets(pending.begin(), pending.end());
+    pending.clear();
+    ++revision;
+}
+
+const MatrixXd& SystemMatrix::dense() const {
+    assert(format == MatrixStorage::Dense);
+    return dense_matrix;
+}
+
+const SparseMatrix& SystemMatrix::sparse() const {
+    assert(format == MatrixStorage::Sparse);
+    return sparse_matrix;
+}
+
+MatrixXd SystemMatrix::to_dense() const {
+    if(format == MatrixStorage::Dense) {
+        return dense_matrix;
+    }
+
+    return MatrixXd(sparse_matrix);
+}
+
+// Writes the matrix into a dense target of the same size, e.g. a block of a larger matrix
+void SystemMatrix::copy_to(Eigen::Ref<MatrixXd> target) const {
+    if(format == MatrixStorage::Dense) {
+        target = dense_matrix;
+        return;
+    }
+
+    target.setZero();
+    for(int j = 0; j < sparse_matrix.outerSize(); ++j) {
+        for(SparseMatrix::InnerIterator it(sparse_matrix, j); it; ++it) {
+            target(it.row(), it.col()) = it.value();
+        }
+    }
+}
+
+VectorXd SystemMatrix::diagonal() const {
+    if(format == MatrixStorage::Dense) {
+        return dense_matrix.diagonal();
+    }
+
+    return sparse_matrix.diagonal();
+}
+
+VectorXd SystemMatrix::multiply(const VectorXd& x) const {
+    if(format == MatrixStorage::Dense) {
+        return dense_matrix*x;
+    }
+
+    return sparse_matrix*x;
+}
+
+double SystemMatrix::max_coeff() const {
+    if(format == MatrixStorage::Dense) {
+        return dense_matrix.maxCoeff();
+    }
+
+    // Entries outside of the pattern are zero
+    double result = (sparse_matrix.nonZeros() < sparse_matrix.rows()*sparse_matrix.cols()) ? 0.0 : std::numeric_limits<double>::lowest();
+    for(int k = 0; k < sparse_matrix.nonZeros(); ++k) {
+        result = std::max(result, sparse_matrix.valuePtr()[k]);
+    }
+
+    return result;
+}
@@ -0,0 +1,77 @@
+#pragma once
+#include "solver/numerics/EigenTypes.hpp"
+#include <Eigen/SparseCore>
+#include <algorithm>
+#include <vector>
+
+using SparseMatrix = Eigen::SparseMatrix<double>;
+
+// Storage formats for the square system matrices (tangent stiffness, tangent damping)
+enum class MatrixStorage {
+    Dense,    // Dense matrix, efficient for small systems
+    Sparse    // Compressed column storage with a sparsity pattern that is kept between assemblies
+};
+
+// Square matrix of the system that is assembled from element contributions by add(i, j, value).
+//
+// With sparse storage, set_zero() only resets the values and keeps the sparsity pattern, so that reassembling
+// the same structure doesn't allocate. Entries that are not yet part of the pattern (e.g. a new contact) are collected
+// and merged into the pattern by finalize(). The pattern therefore only grows and every change of it increments the
+// pattern revision, which allows users of the matrix to cache structural information like symbolic factorizations.
+//
+// Several threads may call add() at the same time as long as they add to different entries.
+// The collected entries are merged in sorted order, so the result doesn't depend on the order in which they were added.
+class SystemMatrix {
+public:
+    SystemMatrix(MatrixStorage storage = MatrixStorage::Dense);
+
+    MatrixStorage storage() const;
+    size_t size() const;
+    size_t pattern_revision() const;
+
+    void resize(size_t n);
+    void set_zero();
+    void add(size_t i, size_t j, double value);
+    void add(const SystemMatrix& A, double factor);    // Adds factor*A, A must have the same size
+    void add_diagonal(const VectorXd& d);
+    void finalize();
+
+    const MatrixXd& dense() const;          // Only valid with dense storage
+    const SparseMatrix& sparse() const;     // Only valid with sparse storage
+
+    MatrixXd to_dense() const;
+    void copy_to(Eigen::Ref<MatrixXd> target) const;
+    VectorXd diagonal() const;
+    VectorXd multiply(const VectorXd& x) const;
+    double max_coeff() const;
+
+private:
+    void add_pending(size_t i, size_t j, double value);
+
+    MatrixStorage format;
+    size_t revision;
+
+    MatrixXd dense_matrix;
+    SparseMatrix sparse_matrix;
+    std::vector<Eigen::Triplet<double>> pending;    // Entries outside of the current sparsity pattern
+};
+
+inline void SystemMatrix::add(size_t i, size_t j, double value) {
+    if(format == MatrixStorage::Dense) {
+        dense_matrix(i, j) += value;
+        return;
+    }
+
+    // Binary search for row i in column j of the compressed matrix
+    const int* indices = sparse_matrix.innerIndexPtr();
+    const int* begin = indices + sparse_matrix.outerIndexPtr()[j];
+    const int* end = indices + sparse_matrix.outerIndexPtr()[j + 1];
+    const int* it = std::lower_bound(begin, end, int(i));
+
+    if(it != end && *it == int(i)) {
+        sparse_matrix.valuePtr()[it - indices] += value;
+    }
+    else {
+        add_pending(i, j, value);
+    }
+}
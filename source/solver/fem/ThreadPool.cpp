@@ -0,0 +1,100 @@
+#include "ThreadPool.hpp"
+#include <algorithm>
+
+ThreadPool::ThreadPool(unsigned threads) {
+    for(unsigned k = 1; k < std::max(threads, 1u); ++k) {
+        workers.emplace_back(&ThreadPool::work, this, k);
+    }
+}
+
+ThreadPool::~ThreadPool() {
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        stop = true;
+    }
+
+    start.notify_all();
+    for(auto& worker: workers) {
+        worker.join();
+    }
+}
+
+unsigned ThreadPool::size() const {
+    return workers.size() + 1;
+}
+
+void ThreadPool::run(size_t n, bool static_schedule, const std::function<void(size_t)>& task) {
+    if(n == 0) {
+        return;
+    }
+
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        n_tasks = n;
+        static_tasks = static_schedule;
+        function = &task;
+        next_task = 0;
+        exception = nullptr;
+        busy = workers.size();
+        ++generation;
+    }
+
+    start.notify_all();
+    execute(0);
+
+    std::unique_lock<std::mutex> lock(mutex);
+    done.wait(lock, [&]{ return busy == 0; });
+    function = nullptr;
+
+    if(exception) {
+        std::rethrow_exception(exception);
+    }
+}
+
+void ThreadPool::work(unsigned thread) {
+    size_t seen = 0;
+    while(true) {
+        {
+            std::unique_lock<std::mutex> lock(mutex);
+            start.wait(lock, [&]{ return stop || generation != seen; });
+            if(stop) {
+                return;
+            }
+
+            seen = generation;
+        }
+
+        execute(thread);
+
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            --busy;
+        }
+
+        done.notify_one();
+    }
+}
+
+// Processes the tasks of the current run that are assigned to the given thread
+void ThreadPool::execute(unsigned thread) {
+    try {
+        if(static_tasks) {
+            size_t first = n_tasks*thread/size();
+            size_t last = n_tasks*(thread + 1)/size();
+            for(size_t i = first; i < last; ++i) {
+                (*function)(i);
+            }
+        }
+        else {
+            for(size_t i = next_task++; i < n_tasks; i = next_task++) {
+                (*function)(i);
+            }
+        }
+    }
+    catch(...) {
+        std::lock_guard<std::mutex> lock(mutex);
+        if(!exception) {
+            exception = std::current_exception();
+        }
+    }
+}
@@ -0,0 +1,50 @@
+#pragma once
+#include <condition_variable>
+#include <exception>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <atomic>
+#include <vector>
+
+// Fixed set of worker threads that process a range of tasks in parallel.
+// The calling thread takes part in the work as thread 0, so a pool of size one doesn't start any workers.
+//
+// With static scheduling, thread k always processes the same contiguous block of the tasks, which makes the
+// assignment of tasks to threads reproducible. Otherwise the tasks are handed out one by one to the next free thread,
+// which balances uneven workloads better.
+
+class ThreadPool {
+public:
+    ThreadPool(unsigned threads);
+    ~ThreadPool();
+
+    ThreadPool(const ThreadPool&) = delete;
+    ThreadPool& operator=(const ThreadPool&) = delete;
+
+    unsigned size() const;
+
+    // Calls task(i) for i in [0, n) and returns once all of them are done.
+    // The first exception thrown by a task is rethrown here.
+    void run(size_t n, bool static_schedule, const std::function<void(size_t)>& task);
+
+private:
+    void work(unsigned thread);
+    void execute(unsigned thread);
+
+    std::vector<std::thread> workers;
+
+    std::mutex mutex;
+    std::condition_variable start;
+    std::condition_variable done;
+    size_t generation = 0;    // Incremented for every call of run()
+    unsigned busy = 0;        // Number of workers that haven't finished the current run yet
+    bool stop = false;
+
+    // Current run
+    size_t n_tasks = 0;
+    bool static_tasks = true;
+    const std::function<void(size_t)>* function = nullptr;
+    std::atomic<size_t> next_task{0};
+    std::exception_ptr exception;
+};
@@ -3,7 +3,7 @@
 
 BarElement::BarElement(System& system, Node node0, Node node1, double L, double EA, double etaA, double rhoA)
     : Element(system),
-      dofs{node0.x, node0.y, node1.x, node1.y},
+      dofs({node0.x, node0.y, node1.x, node1.y}),
       L(L),
       EA(EA),
       etaA(etaA),
@@ -20,16 +20,19 @@ double BarElement::get_length() const
 void BarElement::set_length(double L)
 {
     this->L = L;
+    modified();
 }
 
 void BarElement::set_stiffness(double EA)
 {
     this->EA = EA;
+    modified();
 }
 
 void BarElement::set_damping(double etaA)
 {
     this->etaA = etaA;
+    modified();
 }
 
 double BarElement::get_normal_force() const
@@ -108,3 +111,118 @@ double BarElement::get_kinetic_energy() const
     Vector<4> v = system.get_v(dofs);
     return 0.25*rhoA*L*v.dot(v);
 }
+
+std::vector<Dof> BarElement::get_dofs() const
+{
+    return {dofs.begin(), dofs.end()};
+}
+
+void BarElement::Batch::clear()
+{
+    system = nullptr;
+    dofs.clear();
+
+    L.clear();
+    EA.clear();
+    etaA.clear();
+    rhoA.clear();
+}
+
+void BarElement::Batch::add(const BarElement& element)
+{
+    system = &element.system;
+    dofs.add(element.dofs);
+
+    L.push_back(element.L);
+    EA.push_back(element.EA);
+    etaA.push_back(element.etaA);
+    rhoA.push_back(element.rhoA);
+}
+
+size_t BarElement::Batch::size() const
+{
+    return dofs.size();
+}
+
+void BarElement::Batch::add_masses() const
+{
+    if(size() == 0) {
+        return;
+    }
+
+    for(size_t k = 0; k < 4; ++k) {
+        q[k] = 0.5*Eigen::Map<const ArrayXd>(rhoA.data(), size())*Eigen::Map<const ArrayXd>(L.data(), size());
+    }
+
+    dofs.add_M(*system, q);
+}
+
+void BarElement::Batch::add_internal_forces() const
+{
+    if(size() == 0) {
+        return;
+    }
+
+    dofs.get_u(*system, u);
+    dofs.get_v(*system, v);
+
+    for(size_t k = 0; k < 4; ++k) {
+        q[k].resize(size());
+    }
+
+    // Same as BarElement::add_internal_forces
+    for(size_t i = 0; i < size(); ++i) {
+        double dx = u[2][i] - u[0][i];
+        double dy = u[3][i] - u[1][i];
+        double L_new = std::hypot(dx, dy);
+
+        double dvx = v[2][i] - v[0][i];
+        double dvy = v[3][i] - v[1][i];
+        double L_dot = (dx*dvx + dy*dvy)/L_new;
+
+        double N = EA[i]/L[i]*(L_new - L[i]) + etaA[i]/L[i]*L_dot;
+
+        q[0][i] = -N/L_new*dx;
+        q[1][i] = -N/L_new*dy;
+        q[2][i] =  N/L_new*dx;
+        q[3][i] =  N/L_new*dy;
+    }
+
+    dofs.add_q(*system, q);
+}
+
+double BarElement::Batch::get_potential_energy() const
+{
+    if(size() == 0) {
+        return 0.0;
+    }
+
+    dofs.get_u(*system, u);
+
+    double result = 0.0;
+    for(size_t i = 0; i < size(); ++i) {
+        double dx = u[2][i] - u[0][i];
+        double dy = u[3][i] - u[1][i];
+        double L_new = std::hypot(dx, dy);
+
+        result += 0.5*EA[i]/L[i]*(L_new - L[i])*(L_new - L[i]);
+    }
+
+    return result;
+}
+
+double BarElement::Batch::get_kinetic_energy() const
+{
+    if(size() == 0) {
+        return 0.0;
+    }
+
+    dofs.get_v(*system, v);
+
+    double result = 0.0;
+    for(size_t i = 0; i < size(); ++i) {
+        result += 0.25*rhoA[i]*L[i]*(v[0][i]*v[0][i] + v[1][i]*v[1][i] + v[2][i]*v[2][i] + v[3][i]*v[3][i]);
+    }
+
+    return result;
+}
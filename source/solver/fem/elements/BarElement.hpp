@@ -1,7 +1,10 @@
 #pragma once
 #include "solver/fem/Element.hpp"
 #include "solver/fem/Node.hpp"
+#include "solver/fem/DofView.hpp"
+#include "solver/fem/elements/ElementBatch.hpp"
 #include <array>
+#include <vector>
 
 class BarElement: public Element
 {
@@ -23,8 +26,37 @@ public:
     double get_potential_energy() const override;
     double get_kinetic_energy() const override;
 
+    std::vector<Dof> get_dofs() const override;
+
+    // Copies of bar elements with their parameters in contiguous arrays, evaluated together by batched kernels
+    class Batch {
+    public:
+        void clear();
+        void add(const BarElement& element);
+        size_t size() const;
+
+        void add_masses() const;
+        void add_internal_forces() const;
+
+        double get_potential_energy() const;
+        double get_kinetic_energy() const;
+
+    private:
+        System* system = nullptr;
+        ElementBatch<4> dofs;
+
+        std::vector<double> L;
+        std::vector<double> EA;
+        std::vector<double> etaA;
+        std::vector<double> rhoA;
+
+        mutable std::array<ArrayXd, 4> u;
+        mutable std::array<ArrayXd, 4> v;
+        mutable std::array<ArrayXd, 4> q;
+    };
+
 private:
-    std::array<Dof, 4> dofs;
+    DofMap<4> dofs;
 
     double L;
     double EA;
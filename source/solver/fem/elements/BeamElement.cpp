@@ -1,10 +1,11 @@
 #include "BeamElement.hpp"
 #include "solver/fem/System.hpp"
+#include "solver/numerics/ArrayMath.hpp"
 #include <cstdlib>
 
 BeamElement::BeamElement(System& system, Node node0, Node node1, double rhoA, double L)
     : Element(system),
-      dofs{node0.x, node0.y, node0.phi, node1.x, node1.y, node1.phi},
+      dofs({node0.x, node0.y, node0.phi, node1.x, node1.y, node1.phi}),
       K(Matrix<3, 3>::Zero()),
       D(Matrix<6, 6>::Zero()),
       phi_ref_0(0.0),
@@ -21,6 +22,7 @@ void BeamElement::set_reference_angles(double phi_ref_0, double phi_ref_1)
 {
     this->phi_ref_0 = phi_ref_0;
     this->phi_ref_1 = phi_ref_1;
+    modified();
 }
 
 void BeamElement::set_stiffness(double Cee, double Ckk, double Cek)
@@ -28,11 +30,13 @@ void BeamElement::set_stiffness(double Cee, double Ckk, double Cek)
     K << Cee/L,    -Cek/L,     Cek/L,
         -Cek/L, 4.0*Ckk/L, 2.0*Ckk/L,
          Cek/L, 2.0*Ckk/L, 4.0*Ckk/L;
+    modified();
 }
 
 void BeamElement::set_damping(double beta)
 {
     D =  beta*M(0, 0)*Matrix<6, 6>::Identity();
+    modified();
 }
 
 // p in [0, 1]
@@ -118,6 +122,11 @@ double BeamElement::get_kinetic_energy() const
     return 0.5*v.transpose()*M.asDiagonal()*v;
 }
 
+std::vector<Dof> BeamElement::get_dofs() const
+{
+    return {dofs.begin(), dofs.end()};
+}
+
 Vector<3> BeamElement::get_e() const
 {
     double dx = system.get_u(dofs[3]) - system.get_u(dofs[0]);
@@ -154,3 +163,208 @@ Matrix<3, 6> BeamElement::get_J() const
 
     return J;
 }
+
+void BeamElement::Batch::clear()
+{
+    system = nullptr;
+    dofs.clear();
+
+    L.clear();
+    phi_ref_0.clear();
+    phi_ref_1.clear();
+    d.clear();
+
+    for(auto& k: K) {
+        k.clear();
+    }
+
+    for(auto& m: M) {
+        m.clear();
+    }
+}
+
+void BeamElement::Batch::add(const BeamElement& element)
+{
+    system = &element.system;
+    dofs.add(element.dofs);
+
+    L.push_back(element.L);
+    phi_ref_0.push_back(element.phi_ref_0);
+    phi_ref_1.push_back(element.phi_ref_1);
+    d.push_back(element.D(0, 0));
+
+    K[0].push_back(element.K(0, 0));
+    K[1].push_back(element.K(0, 1));
+    K[2].push_back(element.K(0, 2));
+    K[3].push_back(element.K(1, 1));
+    K[4].push_back(element.K(1, 2));
+    K[5].push_back(element.K(2, 2));
+
+    for(size_t k = 0; k < 6; ++k) {
+        M[k].push_back(element.M(k));
+    }
+}
+
+size_t BeamElement::Batch::size() const
+{
+    return dofs.size();
+}
+
+void BeamElement::Batch::add_masses() const
+{
+    if(size() == 0) {
+        return;
+    }
+
+    for(size_t k = 0; k < 6; ++k) {
+        q[k] = map(M[k]);
+    }
+
+    dofs.add_M(*system, q);
+}
+
+void BeamElement::Batch::add_internal_forces() const
+{
+    if(size() == 0) {
+        return;
+    }
+
+    dofs.get_u(*system, u);
+    dofs.get_v(*system, v);
+    update_e();
+
+    // Same as BeamElement::add_internal_forces, q = J^T*K*e + D*v, with the sparsity of J written out
+    a1 = 1.0/(dx.square() + dy.square());
+    a0 = a1.sqrt();
+
+    j[0] = a0*dx;
+    j[1] = a0*dy;
+    j[2] = a1*dx;
+    j[3] = a1*dy;
+
+    s[0] = map(K[0])*e[0] + map(K[1])*e[1] + map(K[2])*e[2];
+    s[1] = map(K[1])*e[0] + map(K[3])*e[1] + map(K[4])*e[2];
+    s[2] = map(K[2])*e[0] + map(K[4])*e[1] + map(K[5])*e[2];
+
+    q[0] = -j[0]*s[0] - j[3]*(s[1] + s[2]) + map(d)*v[0];
+    q[1] = -j[1]*s[0] + j[2]*(s[1] + s[2]) + map(d)*v[1];
+    q[2] = s[1] + map(d)*v[2];
+    q[3] =  j[0]*s[0] + j[3]*(s[1] + s[2]) + map(d)*v[3];
+    q[4] =  j[1]*s[0] - j[2]*(s[1] + s[2]) + map(d)*v[4];
+    q[5] = s[2] + map(d)*v[5];
+
+    dofs.add_q(*system, q);
+}
+
+void BeamElement::Batch::add_tangent_stiffness() const
+{
+    if(size() == 0) {
+        return;
+    }
+
+    dofs.get_u(*system, u);
+    update_e();
+
+    // Same as BeamElement::add_tangent_stiffness, K = J^T*K*J + Kn, with the sparsity of J, dJ0 and dJ1 written out.
+    // Columns 3 and 4 of J, dJ0 and dJ1 are the negated columns 0 and 1, columns 2 and 5 of J are unit vectors.
+    // Only the upper triangle is assembled, k in row-major order.
+    a1 = 1.0/(dx.square() + dy.square());
+    a0 = a1.sqrt();
+
+    j[0] = a0*dx;
+    j[1] = a0*dy;
+    j[2] = a1*dx;
+    j[3] = a1*dy;
+
+    b[0] = a0*a1*dx.square() - a0;
+    b[1] = a0*a1*dy.square() - a0;
+    b[2] = a0*a1*dx*dy;
+    b[3] = 2.0*a1.square()*dx.square() - a1;
+    b[4] = 2.0*a1.square()*dy.square() - a1;
+    b[5] = 2.0*a1.square()*dx*dy;
+
+    s[0] = map(K[0])*e[0] + map(K[1])*e[1] + map(K[2])*e[2];
+    s[1] = map(K[1])*e[0] + map(K[3])*e[1] + map(K[4])*e[2];
+    s[2] = map(K[2])*e[0] + map(K[4])*e[1] + map(K[5])*e[2];
+
+    // K*J.col(0) and K*J.col(1)
+    c[0] = -map(K[0])*j[0] - (map(K[1]) + map(K[2]))*j[3];
+    c[1] = -map(K[1])*j[0] - (map(K[3]) + map(K[4]))*j[3];
+    c[2] = -map(K[2])*j[0] - (map(K[4]) + map(K[5]))*j[3];
+    c[3] = -map(K[0])*j[1] + (map(K[1]) + map(K[2]))*j[2];
+    c[4] = -map(K[1])*j[1] + (map(K[3]) + map(K[4]))*j[2];
+    c[5] = -map(K[2])*j[1] + (map(K[4]) + map(K[5]))*j[2];
+
+    k[0] = -j[0]*c[0] - j[3]*(c[1] + c[2]) - b[0]*s[0] - b[5]*(s[1] + s[2]);
+    k[1] = -j[0]*c[3] - j[3]*(c[4] + c[5]) - b[2]*s[0] - b[4]*(s[1] + s[2]);
+    k[2] = c[1];
+    k[3] = -k[0];
+    k[4] = -k[1];
+    k[5] = c[2];
+    k[6] = -j[1]*c[3] + j[2]*(c[4] + c[5]) - b[1]*s[0] + b[5]*(s[1] + s[2]);
+    k[7] = c[4];
+    k[8] = -k[1];
+    k[9] = -k[6];
+    k[10] = c[5];
+    k[11] = map(K[3]);
+    k[12] = -c[1];
+    k[13] = -c[4];
+    k[14] = map(K[4]);
+    k[15] = k[0];
+    k[16] = k[1];
+    k[17] = -c[2];
+    k[18] = k[6];
+    k[19] = -c[5];
+    k[20] = map(K[5]);
+
+    dofs.add_K(*system, k);
+}
+
+double BeamElement::Batch::get_potential_energy() const
+{
+    if(size() == 0) {
+        return 0.0;
+    }
+
+    dofs.get_u(*system, u);
+    update_e();
+
+    return (0.5*(map(K[0])*e[0].square() + map(K[3])*e[1].square() + map(K[5])*e[2].square())
+               + map(K[1])*e[0]*e[1] + map(K[2])*e[0]*e[2] + map(K[4])*e[1]*e[2]).sum();
+}
+
+double BeamElement::Batch::get_kinetic_energy() const
+{
+    if(size() == 0) {
+        return 0.0;
+    }
+
+    dofs.get_v(*system, v);
+
+    double result = 0.0;
+    for(size_t k = 0; k < 6; ++k) {
+        result += 0.5*(map(M[k])*v[k].square()).sum();
+    }
+
+    return result;
+}
+
+// Elastic coordinates of all elements, same as BeamElement::get_e. Also leaves the chord components dx, dy for the forces.
+// The angle of the chord is computed by a vectorized atan2 and atan(sin(x)/cos(x)) is replaced by wrapping x onto [-pi/2, pi/2].
+void BeamElement::Batch::update_e() const
+{
+    dx = u[3] - u[0];
+    dy = u[4] - u[1];
+    array_atan2(dy, dx, phi, r);
+
+    e[0] = (dx.square() + dy.square()).sqrt() - map(L);
+    e[1] = u[2] + map(phi_ref_0) - phi;
+    e[2] = u[5] + map(phi_ref_1) - phi;
+    array_wrap_half(e[1]);
+    array_wrap_half(e[2]);
+}
+
+Eigen::Map<const ArrayXd> BeamElement::Batch::map(const std::vector<double>& values) const
+{
+    return Eigen::Map<const ArrayXd>(values.data(), values.size());
+}
@@ -1,8 +1,11 @@
 #pragma once
 #include "solver/fem/Element.hpp"
 #include "solver/fem/Node.hpp"
+#include "solver/fem/DofView.hpp"
+#include "solver/fem/elements/ElementBatch.hpp"
 #include "solver/numerics/EigenTypes.hpp"
 #include <array>
+#include <vector>
 
 class BeamElement: public Element
 {
@@ -24,8 +27,57 @@ public:
     double get_potential_energy() const override;
     double get_kinetic_energy() const override;
 
+    std::vector<Dof> get_dofs() const override;
+
+    // Copies of beam elements with their parameters in contiguous arrays, evaluated together by batched kernels
+    class Batch {
+    public:
+        void clear();
+        void add(const BeamElement& element);
+        size_t size() const;
+
+        void add_masses() const;
+        void add_internal_forces() const;
+        void add_tangent_stiffness() const;
+
+        double get_potential_energy() const;
+        double get_kinetic_energy() const;
+
+    private:
+        System* system = nullptr;
+        ElementBatch<6> dofs;
+
+        std::vector<double> L;
+        std::vector<double> phi_ref_0;
+        std::vector<double> phi_ref_1;
+        std::array<std::vector<double>, 6> K;    // Upper triangle of the symmetric stiffness matrix: K00, K01, K02, K11, K12, K22
+        std::vector<double> d;                   // Damping coefficient, D = d*I
+        std::array<std::vector<double>, 6> M;
+
+        mutable std::array<ArrayXd, 6> u;
+        mutable std::array<ArrayXd, 6> v;
+        mutable std::array<ArrayXd, 6> q;
+        mutable std::array<ArrayXd, 3> e;
+
+        // Intermediate results of the kernels, kept as members so that repeated evaluations don't allocate
+        mutable ArrayXd dx;
+        mutable ArrayXd dy;
+        mutable ArrayXd phi;
+        mutable ArrayXd r;
+        mutable ArrayXd a0;
+        mutable ArrayXd a1;
+        mutable std::array<ArrayXd, 4> j;
+        mutable std::array<ArrayXd, 3> s;
+        mutable std::array<ArrayXd, 6> b;
+        mutable std::array<ArrayXd, 6> c;
+        mutable std::array<ArrayXd, 21> k;
+
+        void update_e() const;
+        Eigen::Map<const ArrayXd> map(const std::vector<double>& values) const;
+    };
+
 private:
-    std::array<Dof, 6> dofs;
+    DofMap<6> dofs;
 
     Vector<6> M;
     Matrix<3, 3> K;
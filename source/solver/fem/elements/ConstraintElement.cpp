@@ -3,7 +3,7 @@
 
 ConstraintElement::ConstraintElement(System& system, Node node0, Node node1, double k)
     : Element(system),
-      dofs{node0.x, node0.y, node0.phi, node1.x, node1.y},
+      dofs({node0.x, node0.y, node0.phi, node1.x, node1.y}),
       k(k)
 {
     double dx_abs = system.get_u(dofs[3]) - system.get_u(dofs[0]);
@@ -74,3 +74,8 @@ double ConstraintElement::get_kinetic_energy() const
 {
     return 0.0;
 }
+
+std::vector<Dof> ConstraintElement::get_dofs() const
+{
+    return {dofs.begin(), dofs.end()};
+}
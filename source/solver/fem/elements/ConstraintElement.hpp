@@ -1,6 +1,7 @@
 #pragma once
 #include "solver/fem/Element.hpp"
 #include "solver/fem/Node.hpp"
+#include "solver/fem/DofView.hpp"
 #include <array>
 
 class ConstraintElement: public Element
@@ -16,8 +17,10 @@ public:
     double get_potential_energy() const override;
     double get_kinetic_energy() const override;
 
+    std::vector<Dof> get_dofs() const override;
+
 private:
-    std::array<Dof, 5> dofs;
+    DofMap<5> dofs;
 
     double k;
     double dx_rel;
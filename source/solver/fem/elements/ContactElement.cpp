@@ -58,7 +58,7 @@ double ContactForce::energy(double e) const
 
 ContactElement::ContactElement(System& system, Node node0, Node node1, Node node2, double h0, double h1, ContactForce f)
     : Element(system),
-      dofs{node0.x, node0.y, node0.phi, node1.x, node1.y, node1.phi, node2.x, node2.y},
+      dofs({node0.x, node0.y, node0.phi, node1.x, node1.y, node1.phi, node2.x, node2.y}),
       h0(h0), h1(h1), f(f)
 {
 
@@ -71,8 +71,11 @@ void ContactElement::add_masses() const
 
 void ContactElement::add_internal_forces() const
 {
-    State state = get_state();
-    system.add_q(dofs, f.force(state.e)*state.De);
+    double e;
+    Vector<8> De;
+    if(get_penetration(system.get_u(dofs), h0, h1, e, De)) {
+        system.add_q(dofs, f.force(e)*De);
+    }
 }
 
 void ContactElement::add_tangent_stiffness() const
@@ -88,8 +91,9 @@ void ContactElement::add_tangent_damping() const
 
 double ContactElement::get_potential_energy() const
 {
-    State state = get_state();
-    return f.energy(state.e);
+    double e;
+    Vector<8> De;
+    return get_penetration(system.get_u(dofs), h0, h1, e, De) ? f.energy(e) : 0.0;
 }
 
 double ContactElement::get_kinetic_energy() const
@@ -97,43 +101,59 @@ double ContactElement::get_kinetic_energy() const
     return 0.0;
 }
 
+std::vector<Dof> ContactElement::get_dofs() const
+{
+    return {dofs.begin(), dofs.end()};
+}
+
 ContactElement::State ContactElement::get_state() const
 {
-    Vector<2> P0{system.get_u(dofs[0]), system.get_u(dofs[1])};
-    Vector<2> P1{system.get_u(dofs[3]), system.get_u(dofs[4])};
-    Vector<2> P2{system.get_u(dofs[6]), system.get_u(dofs[7])};
-    Vector<2> Q0{system.get_u(dofs[0]) + h0*sin(system.get_u(dofs[2])),
-                 system.get_u(dofs[1]) - h0*cos(system.get_u(dofs[2]))};
-    Vector<2> Q1{system.get_u(dofs[3]) + h1*sin(system.get_u(dofs[5])),
-                 system.get_u(dofs[4]) - h1*cos(system.get_u(dofs[5]))};
+    State state;
+    if(!get_penetration(system.get_u(dofs), h0, h1, state.e, state.De, &state.DDe))
+    {
+        return {0.0, Vector<8>::Zero(), Matrix<8, 8>::Zero()};
+    }
 
-    // If no contact, set kinematic expressions to zero and return
+    return state;
+}
+
+bool ContactElement::get_penetration(const Vector<8>& u, double h0, double h1, double& e, Vector<8>& De, Matrix<8, 8>* DDe)
+{
+    Vector<2> P0{u[0], u[1]};
+    Vector<2> P1{u[3], u[4]};
+    Vector<2> P2{u[6], u[7]};
+    Vector<2> Q0{u[0] + h0*sin(u[2]),
+                 u[1] - h0*cos(u[2])};
+    Vector<2> Q1{u[3] + h1*sin(u[5]),
+                 u[4] - h1*cos(u[5])};
+
+    // If no contact, return without calculating the kinematic expressions
     if(get_orientation(P2, P0, Q0) == Orientation::LeftHanded ||
        get_orientation(P2, P1, P0) == Orientation::LeftHanded ||
        get_orientation(P2, Q0, Q1) == Orientation::LeftHanded ||
        get_orientation(P2, Q1, P1) == Orientation::LeftHanded)
     {
-        return {0.0, Vector<8>::Zero(), Matrix<8, 8>::Zero()};
+        return false;
     }
 
     // Contact: Calculate kinematic expressions
 
     // 1. Penetration e
 
-    double a1 = system.get_u(dofs[3]) - system.get_u(dofs[0]) - h0*sin(system.get_u(dofs[2])) + h1*sin(system.get_u(dofs[5]));
-    double a2 = system.get_u(dofs[4]) - system.get_u(dofs[1]) + h0*cos(system.get_u(dofs[2])) - h1*cos(system.get_u(dofs[5]));
-    double a3 = system.get_u(dofs[6]) - system.get_u(dofs[0]) - h0*sin(system.get_u(dofs[2]));
-    double a4 = system.get_u(dofs[7]) - system.get_u(dofs[1]) + h0*cos(system.get_u(dofs[2]));
+    double a1 = u[3] - u[0] - h0*sin(u[2]) + h1*sin(u[5]);
+    double a2 = u[4] - u[1] + h0*cos(u[2]) - h1*cos(u[5]);
+    double a3 = u[6] - u[0] - h0*sin(u[2]);
+    double a4 = u[7] - u[1] + h0*cos(u[2]);
 
-    double e = (a1*a4 - a2*a3)/hypot(a1, a2);
+    e = (a1*a4 - a2*a3)/hypot(a1, a2);
 
     // 2. First derivative of e
 
     Vector<8> Da1, Da2, Da3, Da4;
-    Da1 << -1.0, 0.0, -h0*cos(system.get_u(dofs[2])), 1.0, 0.0, h1*cos(system.get_u(dofs[5])), 0.0, 0.0;
-    Da2 << 0.0, -1.0, -h0*sin(system.get_u(dofs[2])), 0.0, 1.0, h1*sin(system.get_u(dofs[5])), 0.0, 0.0;
-    Da3 << -1.0, 0.0, -h0*cos(system.get_u(dofs[2])), 0.0, 0.0, 0.0, 1.0, 0.0;
-    Da4 << 0.0, -1.0, -h0*sin(system.get_u(dofs[2])), 0.0, 0.0, 0.0, 0.0, 1.0;
+    Da1 << -1.0, 0.0, -h0*cos(u[2]), 1.0, 0.0, h1*cos(u[5]), 0.0, 0.0;
+    Da2 << 0.0, -1.0, -h0*sin(u[2]), 0.0, 1.0, h1*sin(u[5]), 0.0, 0.0;
+    Da3 << -1.0, 0.0, -h0*cos(u[2]), 0.0, 0.0, 0.0, 1.0, 0.0;
+    Da4 << 0.0, -1.0, -h0*sin(u[2]), 0.0, 0.0, 0.0, 0.0, 1.0;
 
     double b1 = 1.0/hypot(a1, a2);
     double b2 = (a2*a3 - a1*a4)/pow(a1*a1 + a2*a2, 1.5);
@@ -141,24 +161,29 @@ ContactElement::State ContactElement::get_state() const
     auto v1 = a4*Da1 - a3*Da2 - a2*Da3 + a1*Da4;
     auto v2 = a1*Da1 + a2*Da2;
 
-    Vector<8> De = b1*v1 + b2*v2;
+    De = b1*v1 + b2*v2;
+
+    if(DDe == nullptr)
+    {
+        return true;
+    }
 
     // 3. Second derivative of e
     // Todo: Don't actually create sparse matrices DDa1 ... DDa4
 
     Matrix<8, 8> DDa1 = Matrix<8, 8>::Zero();
-    DDa1(2, 2) = h0*sin(system.get_u(dofs[2]));
-    DDa1(5, 5) = -h1*sin(system.get_u(dofs[5]));
+    DDa1(2, 2) = h0*sin(u[2]);
+    DDa1(5, 5) = -h1*sin(u[5]);
 
     Matrix<8, 8> DDa2 = Matrix<8, 8>::Zero();
-    DDa2(2, 2) = -h0*cos(system.get_u(dofs[2]));
-    DDa2(5, 5) = h1*cos(system.get_u(dofs[5]));
+    DDa2(2, 2) = -h0*cos(u[2]);
+    DDa2(5, 5) = h1*cos(u[5]);
 
     Matrix<8, 8> DDa3 = Matrix<8, 8>::Zero();
-    DDa3(2, 2) = h0*sin(system.get_u(dofs[2]));
+    DDa3(2, 2) = h0*sin(u[2]);
 
     Matrix<8, 8> DDa4 = Matrix<8, 8>::Zero();
-    DDa4(2, 2) = -h0*cos(system.get_u(dofs[2]));
+    DDa4(2, 2) = -h0*cos(u[2]);
 
     auto Db1 = -(a1*Da1 + a2*Da2)/pow(a1*a1 + a2*a2, 1.5);
 
@@ -175,7 +200,184 @@ ContactElement::State ContactElement::get_state() const
     auto Dv2 = Da1*Da1.transpose() + Da2*Da2.transpose()
              + a1*DDa1 + a2*DDa2;
 
-    Matrix<8, 8> DDe = Db1*v1.transpose() + Db2*v2.transpose() + b1*Dv1 + b2*Dv2;
+    *DDe = Db1*v1.transpose() + Db2*v2.transpose() + b1*Dv1 + b2*Dv2;
+    return true;
+}
+
+ContactElement::Batch::Batch(System& system, ContactForce f)
+    : system(&system), f(f)
+{
+
+}
+
+void ContactElement::Batch::clear()
+{
+    dofs.clear();
+    h0.clear();
+    h1.clear();
+}
+
+void ContactElement::Batch::reserve(size_t n)
+{
+    dofs.reserve(n);
+    h0.reserve(n);
+    h1.reserve(n);
+    reserve_arrays(n);
+}
+
+// Only enlarges the arrays, which therefore don't need to be resized when the number of elements changes
+void ContactElement::Batch::reserve_arrays(size_t n) const
+{
+    if(size_t(e.size()) >= n)
+        return;
+
+    for(size_t k = 0; k < 8; ++k)
+    {
+        u[k].resize(n);
+        q[k].resize(n);
+    }
+
+    for(size_t k = 0; k < 4; ++k)
+    {
+        a[k].resize(n);
+        sc[k].resize(n);
+    }
+
+    e.resize(n);
+    g.resize(n);
+    b1.resize(n);
+    b2.resize(n);
+}
+
+void ContactElement::Batch::add(Node node0, Node node1, Node node2, double h0, double h1)
+{
+    this->dofs.push_back(DofMap<8>({node0.x, node0.y, node0.phi, node1.x, node1.y, node1.phi, node2.x, node2.y}));
+    this->h0.push_back(h0);
+    this->h1.push_back(h1);
+}
+
+size_t ContactElement::Batch::size() const
+{
+    return dofs.size();
+}
+
+void ContactElement::Batch::add_internal_forces() const
+{
+    if(size() == 0)
+        return;
+
+    update_e();
+
+    // Same as ContactElement::add_internal_forces, q = f(e)*De with De = b1*v1 + b2*v2 and the components of v1 and v2 written out.
+    // The penetration of the elements without contact is zero, so their forces vanish.
+    size_t n = size();
+    auto a1 = a[0].head(n);
+    auto a2 = a[1].head(n);
+    auto a3 = a[2].head(n);
+    auto a4 = a[3].head(n);
+    auto sin0 = sc[0].head(n);
+    auto cos0 = sc[1].head(n);
+    auto sin1 = sc[2].head(n);
+    auto cos1 = sc[3].head(n);
+    auto B1 = b1.head(n);
+    auto B2 = b2.head(n);
+    auto G = g.head(n);
+
+    G = f.force(e.head(n));
+    B1 *= G;
+    B2 *= G;
+
+    q[0].head(n) = B1*(a2 - a4) - B2*a1;
+    q[1].head(n) = B1*(a3 - a1) - B2*a2;
+    q[2].head(n) = map(h0)*(B1*((a2 - a4)*cos0 + (a3 - a1)*sin0) - B2*(a1*cos0 + a2*sin0));
+    q[3].head(n) = B1*a4 + B2*a1;
+    q[4].head(n) = B2*a2 - B1*a3;
+    q[5].head(n) = map(h1)*(B1*(a4*cos1 - a3*sin1) + B2*(a1*cos1 + a2*sin1));
+    q[6].head(n) = -B1*a2;
+    q[7].head(n) = B1*a1;
+
+    Vector<8> element_q;
+    for(size_t i = 0; i < n; ++i)
+    {
+        for(size_t k = 0; k < 8; ++k)
+            element_q[k] = q[k][i];
+
+        system->add_q(dofs[i], element_q);
+    }
+}
+
+// The second derivatives of the penetration don't have a compact array form, so the stiffness is evaluated per element
+void ContactElement::Batch::add_tangent_stiffness() const
+{
+    double e;
+    Vector<8> De;
+    Matrix<8, 8> DDe;
+
+    for(size_t i = 0; i < size(); ++i)
+    {
+        if(get_penetration(system->get_u(dofs[i]), h0[i], h1[i], e, De, &DDe))
+            system->add_K(dofs[i], f.stiffness(e)*De*De.transpose() + f.force(e)*e*DDe);
+    }
+}
+
+double ContactElement::Batch::get_potential_energy() const
+{
+    if(size() == 0)
+        return 0.0;
+
+    update_e();
+    return f.energy(e.head(size())).sum();
+}
 
-    return {e, De, DDe};
+// Packs the displacements and evaluates the penetration e of all elements, same as get_penetration, with the contact test
+// by the orientations of the triangles as a mask. Also leaves the terms a1 ... a4, the sines and cosines of the node angles
+// and the factors b1, b2 of the first derivative for the forces.
+void ContactElement::Batch::update_e() const
+{
+    size_t n = size();
+    reserve_arrays(n);
+
+    for(size_t i = 0; i < n; ++i)
+    {
+        Vector<8> element_u = system->get_u(dofs[i]);
+        for(size_t k = 0; k < 8; ++k)
+            u[k][i] = element_u[k];
+    }
+
+    auto U = [&](size_t k) { return u[k].head(n); };
+
+    sc[0].head(n) = U(2).sin();
+    sc[1].head(n) = U(2).cos();
+    sc[2].head(n) = U(5).sin();
+    sc[3].head(n) = U(5).cos();
+
+    // a1, a2: Q1 - Q0, a3, a4: P2 - Q0
+    a[0].head(n) = U(3) - U(0) - map(h0)*sc[0].head(n) + map(h1)*sc[2].head(n);
+    a[1].head(n) = U(4) - U(1) + map(h0)*sc[1].head(n) - map(h1)*sc[3].head(n);
+    a[2].head(n) = U(6) - U(0) - map(h0)*sc[0].head(n);
+    a[3].head(n) = U(7) - U(1) + map(h0)*sc[1].head(n);
+
+    auto a1 = a[0].head(n);
+    auto a2 = a[1].head(n);
+    auto a3 = a[2].head(n);
+    auto a4 = a[3].head(n);
+
+    // Positions of P0, P1, Q0 and Q1 relative to P2 for the orientations of the triangles (P2, P0, Q0), (P2, P1, P0), (P2, Q0, Q1) and (P2, Q1, P1)
+    auto x0 = U(0) - U(6);
+    auto y0 = U(1) - U(7);
+    auto x1 = U(3) - U(6);
+    auto y1 = U(4) - U(7);
+    auto xq1 = a1 - a3;
+    auto yq1 = a2 - a4;
+
+    auto contact = (a3*y0 - a4*x0 >= 0.0) && (x1*y0 - y1*x0 >= 0.0) && (a4*xq1 - a3*yq1 >= 0.0) && (xq1*y1 - yq1*x1 >= 0.0);
+
+    b1.head(n) = (a1.square() + a2.square()).rsqrt();
+    e.head(n) = contact.select((a1*a4 - a2*a3)*b1.head(n), 0.0);
+    b2.head(n) = -e.head(n)*b1.head(n).square();
+}
+
+Eigen::Map<const ArrayXd> ContactElement::Batch::map(const std::vector<double>& values) const
+{
+    return Eigen::Map<const ArrayXd>(values.data(), values.size());
 }
@@ -1,8 +1,10 @@
 #pragma once
 #include "solver/fem/Element.hpp"
 #include "solver/fem/Node.hpp"
+#include "solver/fem/DofView.hpp"
 #include "solver/numerics/EigenTypes.hpp"
 #include <array>
+#include <vector>
 
 struct ContactForce
 {
@@ -12,6 +14,17 @@ public:
     double stiffness(double e) const;
     double energy(double e) const;
 
+    // Elementwise versions for arrays of penetrations
+    template<class Derived>
+    auto force(const Eigen::ArrayBase<Derived>& e) const {
+        return (e <= 0.0).select(0.0, (e <= epsilon).select(k/(2.0*epsilon)*e.square(), k*(e - 0.5*epsilon)));
+    }
+
+    template<class Derived>
+    auto energy(const Eigen::ArrayBase<Derived>& e) const {
+        return (e <= 0.0).select(0.0, (e <= epsilon).select(k/(6.0*epsilon)*e.cube(), 0.5*k*e.square() - 0.5*k*epsilon*e + k/6.0*epsilon*epsilon));
+    }
+
 private:
     double k;
     double epsilon;
@@ -30,8 +43,50 @@ public:
     double get_potential_energy() const override;
     double get_kinetic_energy() const override;
 
+    std::vector<Dof> get_dofs() const override;
+
+    // Contact elements with the same contact force and their parameters in contiguous arrays. The penetrations and forces of all
+    // elements are evaluated together by array expressions over the packed displacements, without the second derivatives that only
+    // the tangent stiffness needs. The arrays keep their capacity when the batch is cleared, so refilling it up to the reserved size
+    // doesn't allocate memory.
+    class Batch {
+    public:
+        Batch(System& system, ContactForce f);
+        void clear();
+        void reserve(size_t n);
+        void add(Node node0, Node node1, Node node2, double h0, double h1);
+        size_t size() const;
+
+        void add_internal_forces() const;
+        void add_tangent_stiffness() const;
+
+        double get_potential_energy() const;
+
+    private:
+        System* system;
+        ContactForce f;
+
+        std::vector<DofMap<8>> dofs;
+        std::vector<double> h0;
+        std::vector<double> h1;
+
+        // Packed displacements and intermediate results, only the first size() entries are used
+        mutable std::array<ArrayXd, 8> u;
+        mutable std::array<ArrayXd, 8> q;
+        mutable std::array<ArrayXd, 4> a;
+        mutable std::array<ArrayXd, 4> sc;
+        mutable ArrayXd e;
+        mutable ArrayXd g;
+        mutable ArrayXd b1;
+        mutable ArrayXd b2;
+
+        void reserve_arrays(size_t n) const;
+        void update_e() const;
+        Eigen::Map<const ArrayXd> map(const std::vector<double>& values) const;
+    };
+
 private:
-    std::array<Dof, 8> dofs;
+    DofMap<8> dofs;
 
     double h0;
     double h1;
@@ -45,4 +100,8 @@ private:
     };
 
     State get_state() const;
+
+    // Penetration e and its first derivative De for the displacements u of the element. The second derivative, which only
+    // the tangent stiffness needs, is only calculated if DDe is given. Returns false if the point is not in contact with the segment.
+    static bool get_penetration(const Vector<8>& u, double h0, double h1, double& e, Vector<8>& De, Matrix<8, 8>* DDe = nullptr);
 };
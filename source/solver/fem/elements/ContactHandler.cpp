@@ -1,9 +1,10 @@
 #include "ContactHandler.hpp"
 #include "solver/fem/System.hpp"
-#include <boost/range/adaptor/map.hpp>
+#include <algorithm>
+#include <cmath>
 
-ContactHandler::ContactHandler(System& system, ContactForce force)
-    : Element(system), force(force)
+ContactHandler::ContactHandler(System& system, ContactForce force, ContactBroadphase broadphase)
+    : Element(system), force(force), broadphase(broadphase), contacts(system, force)
 {
 
 }
@@ -17,6 +18,9 @@ void ContactHandler::add_segment(const Node& node_a, const Node& node_b, double
     y_coordinates.push_back({segments.size(), Coordinate::SegmentMax, 0.0});
 
     segments.push_back({system, node_a, node_b, ha, hb});
+    slots.resize(segments.size()*points.size(), INACTIVE);    // Adds a row of pairs for the new segment
+    u_revision = std::numeric_limits<size_t>::max();
+    modified();    // New DOFs for the colouring
 }
 
 void ContactHandler::add_point(const Node& node)
@@ -24,14 +28,54 @@ void ContactHandler::add_point(const Node& node)
     x_coordinates.push_back({points.size(), Coordinate::PointPos, 0.0});
     y_coordinates.push_back({points.size(), Coordinate::PointPos, 0.0});
 
+    // Move the active pairs to the new layout with an additional column for the new point
+    for(size_t& pair: pairs) {
+        pair = pair/points.size()*(points.size() + 1) + pair%points.size();
+    }
+
+    slots.assign(segments.size()*(points.size() + 1), INACTIVE);
+    for(size_t k = 0; k < pairs.size(); ++k) {
+        slots[pairs[k]] = k;
+    }
+
     points.push_back({system, node});
+    nearest.push_back(0);
+    occupied.push_back(false);
+    tracking = false;
+    u_revision = std::numeric_limits<size_t>::max();
+    modified();    // New DOFs for the colouring
 }
 
 void ContactHandler::update_contacts() const
 {
-    update_coordinates();
-    sort_axis(x_coordinates);
-    sort_axis(y_coordinates);
+    if(system.get_u_revision() == u_revision) {
+        return;
+    }
+
+    // Capacity for the indices of all pairs and for the elements of a chain of points along a chain of segments,
+    // reserved here since copies of the handler don't keep the capacity. More elements are allocated if needed.
+    pairs.reserve(segments.size()*points.size());
+    contacts.reserve(segments.size() + points.size());
+
+    switch(broadphase)
+    {
+    case ContactBroadphase::SweepAndPrune:
+        update_coordinates();
+        sort_axis(x_coordinates);
+        sort_axis(y_coordinates);
+        break;
+
+    case ContactBroadphase::ChainWindow:
+        update_windows();
+        break;
+    }
+
+    if(changed) {
+        update_elements();
+    }
+
+    u_revision = system.get_u_revision();
+    counters.broadphase_updates += 1;
 }
 
 
@@ -59,17 +103,35 @@ void ContactHandler::update_coordinates() const
     }
 }
 
+// Rebuilds the contact elements from the active pairs in order of segments and points, which keeps the summation order
+// of the forces independent of the order in which the pairs became active. Only the active pairs are sorted.
+void ContactHandler::update_elements() const
+{
+    std::sort(pairs.begin(), pairs.end());
+    contacts.clear();
+
+    for(size_t k = 0; k < pairs.size(); ++k)
+    {
+        const Segment& segment = segments[pairs[k]/points.size()];
+        const Point& point = points[pairs[k]%points.size()];
+
+        slots[pairs[k]] = k;
+        contacts.add(segment.node_a, segment.node_b, point.node, segment.h_a, segment.h_b);
+    }
+
+    changed = false;
+}
+
 // Sorts the coordinates of an axis using insertion sort and creates/removes contact elements
 // depending on the occurring swaps. https://en.wikipedia.org/wiki/Insertion_sort
 void ContactHandler::sort_axis(std::vector<Coordinate>& coordinates) const
 {
     auto add_contact = [&](size_t i, size_t j) {
-        contacts.insert({{i, j}, {system, segments[i].node_a, segments[i].node_b,
-                                  points[j].node, segments[i].h_a, segments[i].h_b, force}});
+        set_active(i, j, true);
     };
 
     auto remove_contact = [&](size_t i, size_t j) {
-        contacts.erase({i, j});
+        set_active(i, j, false);
     };
 
     for(int j = 1; j < coordinates.size(); j++)
@@ -122,6 +184,119 @@ void ContactHandler::sort_axis(std::vector<Coordinate>& coordinates) const
     }
 }
 
+// Moves the nearest segment of each point along the chain as long as the distance decreases, then activates the pairs
+// with the segments in the window around it whose bounding boxes contain the point and deactivates all others.
+// Points outside of all bounding boxes of the window and without active pairs are skipped.
+void ContactHandler::update_windows() const
+{
+    if(segments.empty())
+        return;
+
+    bounds.resize(segments.size());
+    for(size_t i = 0; i < segments.size(); ++i)
+    {
+        const Segment& segment = segments[i];
+        double x_a = system.get_u(segment.node_a.x);
+        double y_a = system.get_u(segment.node_a.y);
+        double dx = system.get_u(segment.node_b.x) - x_a;
+        double dy = system.get_u(segment.node_b.y) - y_a;
+
+        bounds[i].x_a = x_a;
+        bounds[i].y_a = y_a;
+        bounds[i].dx = dx;
+        bounds[i].dy = dy;
+        bounds[i].l2_inv = 1.0/(dx*dx + dy*dy);
+        bounds[i].box = {segment.get_x_min(), segment.get_x_max(), segment.get_y_min(), segment.get_y_max()};
+    }
+
+    for(size_t i = 0; i < segments.size(); ++i)
+    {
+        Box& window = bounds[i].window;
+        window = bounds[i].box;
+
+        for(size_t k = (i > WINDOW) ? i - WINDOW : 0; k <= std::min(i + WINDOW, segments.size() - 1); ++k)
+        {
+            window.x_min = std::min(window.x_min, bounds[k].box.x_min);
+            window.x_max = std::max(window.x_max, bounds[k].box.x_max);
+            window.y_min = std::min(window.y_min, bounds[k].box.y_min);
+            window.y_max = std::max(window.y_max, bounds[k].box.y_max);
+        }
+    }
+
+    for(size_t j = 0; j < points.size(); ++j)
+    {
+        double x = points[j].get_x();
+        double y = points[j].get_y();
+
+        // Initial guess: The nearest segment of the previous point along the chain
+        size_t i = (tracking || j == 0) ? nearest[j] : nearest[j-1];
+        double d = bounds[i].get_distance2(x, y);
+
+        while(i > 0 && bounds[i-1].get_distance2(x, y) < d)
+        {
+            --i;
+            d = bounds[i].get_distance2(x, y);
+        }
+        while(i < segments.size() - 1 && bounds[i+1].get_distance2(x, y) < d)
+        {
+            ++i;
+            d = bounds[i].get_distance2(x, y);
+        }
+
+        if(occupied[j] || bounds[i].window.contains(x, y))
+        {
+            // Deactivate the pairs of the previous window that aren't part of the new one, then update the new window
+            size_t i_min = (i > WINDOW) ? i - WINDOW : 0;
+            size_t i_max = std::min(i + WINDOW, segments.size() - 1);
+
+            if(i != nearest[j])
+            {
+                size_t i_prev_min = (nearest[j] > WINDOW) ? nearest[j] - WINDOW : 0;
+                size_t i_prev_max = std::min(nearest[j] + WINDOW, segments.size() - 1);
+
+                for(size_t k = i_prev_min; k <= i_prev_max; ++k)
+                {
+                    if(k < i_min || k > i_max)
+                        set_active(k, j, false);
+                }
+            }
+
+            occupied[j] = false;
+            for(size_t k = i_min; k <= i_max; ++k)
+            {
+                bool contact = bounds[k].box.contains(x, y);
+                set_active(k, j, contact);
+                occupied[j] = occupied[j] || contact;
+            }
+        }
+
+        nearest[j] = i;
+    }
+
+    tracking = true;
+}
+
+// Adds the pair to the end of the list of active pairs or replaces it by the last one, keeping the slots of the pairs up to date
+void ContactHandler::set_active(size_t i, size_t j, bool value) const
+{
+    size_t pair = i*points.size() + j;
+    if(value && slots[pair] == INACTIVE)
+    {
+        slots[pair] = pairs.size();
+        pairs.push_back(pair);
+        changed = true;
+    }
+    else if(!value && slots[pair] != INACTIVE)
+    {
+        size_t k = slots[pair];
+        pairs[k] = pairs.back();
+        slots[pairs[k]] = k;
+        pairs.pop_back();
+        slots[pair] = INACTIVE;
+        changed = true;
+    }
+}
+
 void ContactHandler::add_masses() const
 {
 
@@ -129,18 +304,16 @@ void ContactHandler::add_masses() const
 
 void ContactHandler::add_internal_forces() const
 {
+    counters.force_calls += 1;
     update_contacts();
-
-    for(auto& e: contacts | boost::adaptors::map_values)
-        e.add_internal_forces();
+    contacts.add_internal_forces();
 }
 
 void ContactHandler::add_tangent_stiffness() const
 {
-    update_contacts();    // Todo: Avoid Recomputation.
-
-    for(auto& e: contacts | boost::adaptors::map_values)
-        e.add_tangent_stiffness();
+    counters.stiffness_calls += 1;
+    update_contacts();
+    contacts.add_tangent_stiffness();
 }
 
 void ContactHandler::add_tangent_damping() const
@@ -150,11 +323,7 @@ void ContactHandler::add_tangent_damping() const
 
 double ContactHandler::get_potential_energy() const
 {
-    double T = 0.0;
-    for(auto& e: contacts | boost::adaptors::map_values)
-        T += e.get_potential_energy();
-
-    return T;
+    return contacts.get_potential_energy();
 }
 
 double ContactHandler::get_kinetic_energy() const
@@ -162,6 +331,31 @@ double ContactHandler::get_kinetic_energy() const
     return 0.0;
 }
 
+std::vector<Dof> ContactHandler::get_dofs() const
+{
+    std::vector<Dof> dofs;
+    for(auto& segment: segments)
+    {
+        for(const Node& node: {segment.node_a, segment.node_b})
+            dofs.insert(dofs.end(), {node.x, node.y, node.phi});
+    }
+
+    for(auto& point: points)
+        dofs.insert(dofs.end(), {point.node.x, point.node.y, point.node.phi});
+
+    return dofs;
+}
+
+const ContactHandler::Counters& ContactHandler::get_counters() const
+{
+    return counters;
+}
+
+void ContactHandler::reset_counters()
+{
+    counters = Counters();
+}
+
 double ContactHandler::Segment::get_x_min() const
 {
     return std::min(system.get_u(node_a.x) - h_a, system.get_u(node_b.x) - h_b);
@@ -182,6 +376,20 @@ double ContactHandler::Segment::get_y_max() const
     return std::max(system.get_u(node_a.y) + h_a, system.get_u(node_b.y) + h_b);
 }
 
+double ContactHandler::SegmentBounds::get_distance2(double x, double y) const
+{
+    double t = std::clamp(((x - x_a)*dx + (y - y_a)*dy)*l2_inv, 0.0, 1.0);    // Parameter of the closest point on the segment
+    double ex = x_a + t*dx - x;
+    double ey = y_a + t*dy - y;
+
+    return ex*ex + ey*ey;
+}
+
+bool ContactHandler::Box::contains(double x, double y) const
+{
+    return x > x_min && x <= x_max && y > y_min && y <= y_max;
+}
+
 double ContactHandler::Point::get_x() const
 {
     return system.get_u(node.x);
@@ -3,7 +3,7 @@
 #include "solver/fem/Element.hpp"
 #include "solver/fem/Node.hpp"
 #include <vector>
-#include <map>
+#include <limits>
 
 // Holds a collection of segments (two nodes, two distances) and points (one node) and creates/removes
 // contact elements for them as needed. It uses the Sweep and Prune broadphase algorithm [1],[2] along
@@ -12,8 +12,29 @@
 // [1] https://github.com/mattleisolver/model/jitterphysics/wiki/Sweep-and-Prune
 // [2] http://codercorner.com/SAP.pdf
 //
-// Todo: Dynamic memory allocation when inserting in the map. Maybe try unordered_map?
-// It has a reserve method, but iteration should be slower.
+// Alternatively, if the segments form a chain (like the limb) and the points are added in order along another chain (like the string),
+// each point can keep track of its nearest segment by walking along the chain from the previous one, similar to find_interval.
+// Only the segments in a small window around it are then tested for contact with the same bounding box test, which is O(n)
+// without any sorting. Contacts with segments outside of the window are missed, which requires the chain not to fold back
+// onto itself within the thickness of the segments.
+//
+// The contacts only depend on the displacements, so the broadphase runs at most once per revision of the displacements
+// of the system, even though both the internal forces and the tangent stiffness need the current contacts.
+//
+// The active pairs of segments and points are kept in a compact list, with the position of each pair in the list stored in a slot
+// per possible pair. Adding a pair appends it to the list and removing one moves the last pair into its place, both in constant
+// time and without allocating memory, since the list has capacity for all pairs. After a change the list is sorted and the contact
+// elements are rebuilt from it, ordered by segment and point. Their storage has capacity for S + P contacts (S segments, P points),
+// as many as a chain of points along a chain of segments usually has, so the updates are allocation-free up to S + P active contacts.
+// The contact elements are kept in a batch, which evaluates the forces of all active pairs in one pass over their packed displacements
+// and without the second derivatives of the penetration, which only the tangent stiffness needs.
+
+// Broadphase algorithms for finding the pairs of segments and points that can come into contact
+enum class ContactBroadphase
+{
+    SweepAndPrune,    // Sorts the bounding boxes of segments and points along both axes, no assumptions about the geometry
+    ChainWindow       // Tracks the nearest segment of each point along the chain of segments and tests only the ones close to it
+};
 
 class ContactHandler: public Element
 {
@@ -32,6 +53,30 @@ private:
         double get_y_max() const;
     };
 
+    struct Box
+    {
+        double x_min;
+        double x_max;
+        double y_min;
+        double y_max;
+
+        bool contains(double x, double y) const;    // Same as Point::intersects_aabb
+    };
+
+    // Current geometry of a segment, evaluated once per update of the chain window broadphase
+    struct SegmentBounds
+    {
+        double x_a;       // Position of the first node
+        double y_a;
+        double dx;        // Difference of the node positions
+        double dy;
+        double l2_inv;    // Inverse of the squared length
+        Box box;          // Bounding box of the segment
+        Box window;       // Union of the bounding boxes of the segments in the window around this segment
+
+        double get_distance2(double x, double y) const;    // Squared distance of a point to the line segment between the nodes
+    };
+
     struct Point
     {
         System& system;
@@ -53,13 +98,24 @@ private:
     };
 
 public:
-    ContactHandler(System& system, ContactForce force);
+    // Number of evaluations, for checking that the broadphase isn't repeated unnecessarily
+    struct Counters
+    {
+        size_t force_calls = 0;
+        size_t stiffness_calls = 0;
+        size_t broadphase_updates = 0;
+    };
+
+    ContactHandler(System& system, ContactForce force, ContactBroadphase broadphase = ContactBroadphase::SweepAndPrune);
     void add_segment(const Node& node_a, const Node& node_b, double ha, double hb);
     void add_point(const Node& node);
 
-    void update_contacts() const;
+    void update_contacts() const;    // Does nothing if the displacements didn't change since the last update
     void update_coordinates() const;
+    void update_elements() const;
     void sort_axis(std::vector<Coordinate>& coordinates) const;
+    void update_windows() const;
+    void set_active(size_t i, size_t j, bool value) const;    // Activates or deactivates a pair, marks the pairs as changed if necessary
 
     virtual void add_masses() const override;
     virtual void add_internal_forces() const override;
@@ -69,13 +125,32 @@ public:
     virtual double get_potential_energy() const override;
     virtual double get_kinetic_energy() const override;
 
+    virtual std::vector<Dof> get_dofs() const override;
+
+    const Counters& get_counters() const;
+    void reset_counters();
+
 private:
     std::vector<Segment> segments;
     std::vector<Point> points;
     ContactForce force;
+    ContactBroadphase broadphase;
 
     mutable std::vector<Coordinate> x_coordinates;
     mutable std::vector<Coordinate> y_coordinates;
-    mutable std::map<std::pair<size_t, size_t>, ContactElement> contacts;
+    static constexpr size_t INACTIVE = std::numeric_limits<size_t>::max();    // Slot of an inactive pair
+    mutable std::vector<size_t> pairs;                // Active pairs, index i*points.size() + j for segment i and point j
+    mutable std::vector<size_t> slots;                // Position of each pair in the active pairs or INACTIVE
+    mutable ContactElement::Batch contacts;           // Elements of the active pairs, sorted
+    mutable bool changed = false;                     // Whether the active pairs changed since the elements were built
+
+    static const size_t WINDOW = 2;                   // Number of segments on each side of the nearest one that are tested for contact
+    mutable std::vector<size_t> nearest;              // Index of the nearest segment of each point
+    mutable std::vector<char> occupied;               // Whether a point has any active pairs
+    mutable std::vector<SegmentBounds> bounds;        // Current bounds of the segments
+    mutable bool tracking = false;                    // Whether the nearest segments have been initialized
+
+    mutable size_t u_revision = std::numeric_limits<size_t>::max();    // Revision of the displacements at the last update, if any
+    mutable Counters counters;
 };
 
@@ -0,0 +1,90 @@
+#include "ElementBatch.hpp"
+#include "solver/fem/System.hpp"
+
+template<size_t N>
+void ElementBatch<N>::clear() {
+    dofs.clear();
+}
+
+template<size_t N>
+void ElementBatch<N>::add(const DofMap<N>& element_dofs) {
+    dofs.push_back(element_dofs);
+}
+
+template<size_t N>
+size_t ElementBatch<N>::size() const {
+    return dofs.size();
+}
+
+template<size_t N>
+void ElementBatch<N>::get_u(const System& system, std::array<ArrayXd, N>& u) const {
+    for(size_t k = 0; k < N; ++k) {
+        u[k].resize(size());
+    }
+
+    for(size_t i = 0; i < size(); ++i) {
+        Vector<N> element_u = system.get_u(dofs[i]);
+        for(size_t k = 0; k < N; ++k) {
+            u[k][i] = element_u[k];
+        }
+    }
+}
+
+template<size_t N>
+void ElementBatch<N>::get_v(const System& system, std::array<ArrayXd, N>& v) const {
+    for(size_t k = 0; k < N; ++k) {
+        v[k].resize(size());
+    }
+
+    for(size_t i = 0; i < size(); ++i) {
+        Vector<N> element_v = system.get_v(dofs[i]);
+        for(size_t k = 0; k < N; ++k) {
+            v[k][i] = element_v[k];
+        }
+    }
+}
+
+template<size_t N>
+void ElementBatch<N>::add_q(System& system, const std::array<ArrayXd, N>& q) const {
+    Vector<N> element_q;
+    for(size_t i = 0; i < size(); ++i) {
+        for(size_t k = 0; k < N; ++k) {
+            element_q[k] = q[k][i];
+        }
+
+        system.add_q(dofs[i], element_q);
+    }
+}
+
+template<size_t N>
+void ElementBatch<N>::add_M(System& system, const std::array<ArrayXd, N>& M) const {
+    Vector<N> element_M;
+    for(size_t i = 0; i < size(); ++i) {
+        for(size_t k = 0; k < N; ++k) {
+            element_M[k] = M[k][i];
+        }
+
+        system.add_M(dofs[i], element_M);
+    }
+}
+
+template<size_t N>
+void ElementBatch<N>::add_K(System& system, const std::array<ArrayXd, N*(N+1)/2>& K) const {
+    Matrix<N, N> element_K;
+    for(size_t i = 0; i < size(); ++i) {
+        size_t k = 0;
+        for(size_t row = 0; row < N; ++row) {
+            for(size_t col = row; col < N; ++col, ++k) {
+                element_K(row, col) = K[k][i];
+                element_K(col, row) = K[k][i];
+            }
+        }
+
+        system.add_K(dofs[i], element_K);
+    }
+}
+
+// Instantiations for the element types: Mass (3), bar (4), beam (6)
+template class ElementBatch<3>;
+template class ElementBatch<4>;
+template class ElementBatch<6>;
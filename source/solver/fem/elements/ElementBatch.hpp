@@ -0,0 +1,28 @@
+#pragma once
+#include "solver/fem/Node.hpp"
+#include "solver/fem/DofView.hpp"
+#include "solver/numerics/EigenTypes.hpp"
+#include <array>
+#include <vector>
+
+class System;
+
+// DOFs of a batch of elements of the same type, stored as the DOF maps of the elements.
+// Gathers displacements and velocities of all elements into one contiguous array per local DOF (structure of arrays)
+// and adds the results of a batched kernel (forces, masses, stiffness) back into the system. Used by the batch classes of the element types.
+template<size_t N>
+class ElementBatch {
+public:
+    void clear();
+    void add(const DofMap<N>& dofs);
+    size_t size() const;
+
+    void get_u(const System& system, std::array<ArrayXd, N>& u) const;
+    void get_v(const System& system, std::array<ArrayXd, N>& v) const;
+    void add_q(System& system, const std::array<ArrayXd, N>& q) const;
+    void add_M(System& system, const std::array<ArrayXd, N>& M) const;
+    void add_K(System& system, const std::array<ArrayXd, N*(N+1)/2>& K) const;    // Upper triangle of symmetric matrices, row by row
+
+private:
+    std::vector<DofMap<N>> dofs;
+};
@@ -3,7 +3,7 @@
 
 MassElement::MassElement(System& system, Node node, double m, double I)
     : Element(system),
-      dofs{node.x, node.y, node.phi},
+      dofs({node.x, node.y, node.phi}),
       m(m),
       I(I)
 {
@@ -17,7 +17,8 @@ MassElement::MassElement(System& system, Node node, double m, double I)
 
 void MassElement::set_node(Node node)
 {
-    dofs = {node.x, node.y, node.phi};
+    dofs = DofMap<3>({node.x, node.y, node.phi});
+    modified();
 }
 
 void MassElement::add_masses() const
@@ -50,3 +51,72 @@ double MassElement::get_kinetic_energy() const
     return 0.5*m*(pow(system.get_v(dofs[0]), 2) + pow(system.get_v(dofs[1]), 2))
          + 0.5*I*pow(system.get_v(dofs[2]), 2);
 }
+
+std::vector<Dof> MassElement::get_dofs() const
+{
+    return {dofs.begin(), dofs.end()};
+}
+
+void MassElement::Batch::clear()
+{
+    system = nullptr;
+    dofs.clear();
+
+    for(auto& m: M) {
+        m.clear();
+    }
+}
+
+void MassElement::Batch::add(const MassElement& element)
+{
+    system = &element.system;
+    dofs.add(element.dofs);
+
+    M[0].push_back(element.m);
+    M[1].push_back(element.m);
+    M[2].push_back(element.I);
+}
+
+size_t MassElement::Batch::size() const
+{
+    return dofs.size();
+}
+
+void MassElement::Batch::add_masses() const
+{
+    if(size() == 0) {
+        return;
+    }
+
+    for(size_t k = 0; k < 3; ++k) {
+        v[k] = Eigen::Map<const ArrayXd>(M[k].data(), size());
+    }
+
+    dofs.add_M(*system, v);
+}
+
+void MassElement::Batch::add_internal_forces() const
+{
+
+}
+
+double MassElement::Batch::get_potential_energy() const
+{
+    return 0.0;
+}
+
+double MassElement::Batch::get_kinetic_energy() const
+{
+    if(size() == 0) {
+        return 0.0;
+    }
+
+    dofs.get_v(*system, v);
+
+    double result = 0.0;
+    for(size_t k = 0; k < 3; ++k) {
+        result += 0.5*(Eigen::Map<const ArrayXd>(M[k].data(), size())*v[k].square()).sum();
+    }
+
+    return result;
+}
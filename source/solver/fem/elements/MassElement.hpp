@@ -1,7 +1,10 @@
 #pragma once
 #include "solver/fem/Element.hpp"
 #include "solver/fem/Node.hpp"
+#include "solver/fem/DofView.hpp"
+#include "solver/fem/elements/ElementBatch.hpp"
 #include <array>
+#include <vector>
 
 class MassElement: public Element
 {
@@ -17,8 +20,31 @@ public:
     double get_potential_energy() const override;
     double get_kinetic_energy() const override;
 
+    std::vector<Dof> get_dofs() const override;
+
+    // Copies of mass elements with their parameters in contiguous arrays, evaluated together by batched kernels
+    class Batch {
+    public:
+        void clear();
+        void add(const MassElement& element);
+        size_t size() const;
+
+        void add_masses() const;
+        void add_internal_forces() const;
+
+        double get_potential_energy() const;
+        double get_kinetic_energy() const;
+
+    private:
+        System* system = nullptr;
+        ElementBatch<3> dofs;
+        std::array<std::vector<double>, 3> M;
+
+        mutable std::array<ArrayXd, 3> v;
+    };
+
 private:
-    std::array<Dof, 3> dofs;
+    DofMap<3> dofs;
     double m;
     double I;
 };
@@ -3,6 +3,7 @@
 #include "solver/fem/EigenvalueSolver.hpp"
 #include "solver/fem/StaticSolver.hpp"
 #include "solver/fem/DynamicSolver.hpp"
+#include "solver/fem/PathStates.hpp"
 #include "solver/fem/elements/BeamElement.hpp"
 #include "solver/fem/elements/BarElement.hpp"
 #include "solver/fem/elements/MassElement.hpp"
@@ -10,12 +11,15 @@
 #include "solver/fem/elements/ContactHandler.hpp"
 #include "solver/numerics/RootFinding.hpp"
 #include "solver/numerics/Geometry.hpp"
+#include <algorithm>
 #include <limits>
+#include <map>
 #include <numeric>
+#include <utility>
 #include <cmath>
 
-OutputData BowModel::simulate(const InputData& input, SimulationMode mode, const Callback& callback) {
-    BowModel model(input);
+OutputData BowModel::simulate(const InputData& input, SimulationMode mode, const Callback& callback, const SimulationOptions& options) {
+    BowModel model(input, options);
 
     SetupData setup = model.simulate_setup(callback);
     BowStates static_states = model.simulate_statics(callback);
@@ -25,16 +29,34 @@ OutputData BowModel::simulate(const InputData& input, SimulationMode mode, const
         dynamic_states = model.simulate_dynamics(callback);
     }
 
-    return OutputData(setup, static_states, dynamic_states);
+    return OutputData(std::move(setup), std::move(static_states), std::move(dynamic_states));
 }
 
-BowModel::BowModel(const InputData& input)
-    : input(input)
+void BowModel::simulate(const InputData& input, SimulationMode mode, const Callback& callback, OutputWriter& writer, const SimulationOptions& options) {
+    BowModel model(input, options);
+
+    SetupData setup = model.simulate_setup(callback);
+    OutputData output(std::move(setup), model.simulate_statics(callback), BowStates());    // Only setup and statics
+    writer.begin(output.setup, output.statics);
+
+    if(mode == SimulationMode::Dynamic) {
+        model.simulate_dynamics(callback, &writer);
+    }
+
+    writer.finish();
+}
+
+BowModel::BowModel(const InputData& input, const SimulationOptions& options)
+    : input(input),
+      options(options),
+      system(MatrixStorage::Sparse)
 {
     std::string error = input.validate();
     if(!error.empty()) {
         throw std::runtime_error(error);
     }
+
+    system.mut_elements().set_parallel(options.threads, options.deterministic);
 }
 
 void BowModel::init_limb(const Callback& callback, SetupData& output) {
@@ -68,28 +90,64 @@ void BowModel::init_limb(const Callback& callback, SetupData& output) {
     }
 
     // Tune damping parameter
+    if(input.damping.damping_ratio_limbs > 0.0) {
+        tune_damping(system, "limb", input.damping.damping_ratio_limbs);
+    }
+
+    // Assign discrete limb properties
+    output.limb_properties = limb_properties;
+    output.limb_mass = std::accumulate(limb_properties.m.begin(), limb_properties.m.end(), 0.0) + input.masses.limb_tip;
+}
+
+// The damping matrix of the beams is linear in the damping parameter, D = beta*D1. The lowest undamped modes are computed once
+// and the damping ratio of the lowest mode is evaluated on the system reduced to these modes, (diag(omega^2), beta*Phi^T*D1*Phi, I).
+// The secant iteration on the reduced system starts at beta_0 = 2*zeta*omega/(phi^T*D1*phi), the solution for the lowest mode
+// alone. This is only a starting value: D1 scales all DOFs of a beam with its translational mass, including the rotational ones,
+// so the damping isn't proportional to the masses and the modes are coupled by it, also with modes outside of the reduced basis.
+double BowModel::tune_damping(System& system, const std::string& group, double zeta) {
+    for(auto& element: system.mut_elements().group<BeamElement>(group)) {
+        element.set_damping(1.0);
+    }
 
+    VectorXd omega;
+    MatrixXd modes;
     EigenvalueSolver solver(system);
-    auto try_damping_parameter = [&](double beta) {
-        for(auto& element: system.mut_elements().group<BeamElement>("limb")) {
+    solver.compute_undamped_modes(8, omega, modes);    // Magic number
+
+    MatrixXd K_r = omega.cwiseAbs2().asDiagonal();
+    MatrixXd M_r = MatrixXd::Identity(omega.size(), omega.size());
+    MatrixXd D_r(omega.size(), omega.size());
+    for(int j = 0; j < modes.cols(); ++j) {
+        D_r.col(j) = modes.transpose()*system.get_D().multiply(modes.col(j));
+    }
+
+    auto set_damping_parameter = [&](double beta) {
+        for(auto& element: system.mut_elements().group<BeamElement>(group)) {
             element.set_damping(beta);
         }
+    };
 
-        return solver.compute_minimum_frequency().zeta - input.damping.damping_ratio_limbs;
+    auto reduced_damping_ratio = [&](double beta) {
+        return EigenvalueSolver::compute_minimum_frequency(K_r, beta*D_r, M_r).zeta;
     };
 
-    if(input.damping.damping_ratio_limbs > 0.0)
-        secant_method(try_damping_parameter, 1.0, 1.5, 1e-5, 15);    // Magic numbers
+    double beta_0 = 2.0*zeta*omega(0)/D_r(0, 0);
+    double beta = secant_method([&](double beta) { return reduced_damping_ratio(beta) - zeta; }, beta_0, 1.1*beta_0, 1e-7, 15);    // Magic numbers
 
-    // Assign discrete limb properties
-    output.limb_properties = limb_properties;
-    output.limb_mass = std::accumulate(limb_properties.m.begin(), limb_properties.m.end(), 0.0) + input.masses.limb_tip;
+    // The reduced system misses the coupling with the higher modes by the damping. Its error at beta is evaluated once on the full system
+    // and the reduced system is solved again for the target corrected by this error, which changes only slowly with beta.
+    set_damping_parameter(beta);
+    double error = solver.compute_minimum_frequency().zeta - reduced_damping_ratio(beta);
+    beta = secant_method([&](double beta) { return reduced_damping_ratio(beta) + error - zeta; }, beta, 1.01*beta, 1e-7, 15);    // Magic numbers
+
+    set_damping_parameter(beta);
+    return beta;
 }
 
 void BowModel::init_string(const Callback& callback, SetupData& output) {
     LimbProperties& limb_properties = output.limb_properties;
 
-    const double k = 0.1*std::abs(system.get_K().maxCoeff());         // Contact stiffness in terms of maximum stiffness already present // Magic number
+    const double k = 0.1*std::abs(system.get_K().max_coeff());         // Contact stiffness in terms of maximum stiffness already present // Magic number
     const double epsilon = 0.01*limb_properties.height.minCoeff();    // Initial penetration of the contact elements // Magic number
 
     // Calculate curve tangential to the limb and calculate string node positions by equipartition
@@ -123,7 +181,7 @@ void BowModel::init_string(const Callback& callback, SetupData& output) {
 
     // Create string to limb contact surface and limb tip constraint
 
-    ContactHandler contact(system, ContactForce(k, epsilon));
+    ContactHandler contact(system, ContactForce(k, epsilon), options.contact_broadphase);
     for(size_t i = 1; i < nodes_limb.size(); ++i) {
         contact.add_segment(nodes_limb[i-1], nodes_limb[i], limb_properties.height[i-1], limb_properties.height[i]);
     }
@@ -134,53 +192,138 @@ void BowModel::init_string(const Callback& callback, SetupData& output) {
     system.mut_elements().add(contact, "contact");
     system.mut_elements().add(ConstraintElement(system, nodes_limb.back(), nodes_string.back(), k), "constraint");
 
-    // Takes a string element length, iterates to equilibrium with the constraint of the brace height
-    // and returns the angle of the string center
-    system.set_p(nodes_string[0].y, 1.0);    // Will be scaled by the static algorithm
-    StaticSolverDC solver(system, nodes_string[0].y);   // Todo: Reuse solver across function calls?
-    StaticSolverDC::Info info;
-    auto try_element_length = [&](double l) {
+    // Equilibrium state with the constraint of the brace height for a string element length, with the angle of the string center
+    // and the derivatives of the displacements and the angle with respect to the element length
+    struct Trial {
+        double l;
+        double alpha;
+        double dalpha;
+        VectorXd u;
+        VectorXd p;
+        VectorXd dudl;
+    };
+
+    auto set_element_length = [&](double l) {
         for(auto& element: system.mut_elements().group<BarElement>("string")) {
             element.set_length(l);
         }
+    };
+
+    // Iterates to equilibrium for the element length l, starting from a linear extrapolation of the given trial if any,
+    // otherwise from the current state. The sensitivities reuse the last factorization of the solver. Returns whether the solver
+    // converged, the angle and the state are set in either case.
+    system.set_p(nodes_string[0].y, 1.0);    // Will be scaled by the static algorithm
+    StaticSolverDC solver(system, nodes_string[0].y);
+    auto try_element_length = [&](double l, const Trial* start, Trial& trial) {
+        if(start != nullptr) {
+            system.set_u(start->u + (l - start->l)*start->dudl);
+            system.set_p(start->p);
+        }
+
+        set_element_length(l);
+        StaticSolverDC::Info info = solver.solve(-input.dimensions.brace_height);
+
+        trial.l = l;
+        trial.alpha = system.get_angle(nodes_string[0], nodes_string[1]);
+        trial.u = system.get_u();
+        trial.p = system.get_p();
+        if(info.outcome != StaticSolverDC::Info::Success) {
+            return false;
+        }
+
+        // Derivative of the internal forces with respect to the element length by a finite difference
+        double h = 1e-6*l;    // Magic number
+        VectorXd q = system.get_q();
+        set_element_length(l + h);
+        VectorXd dqdl = (system.get_q() - q)/h;
+        set_element_length(l);
+
+        trial.dudl = solver.get_sensitivity(dqdl);
+
+        // Derivative of the angle of the string center
+        auto get_dudl = [&](Dof dof) {
+            return dof.active ? trial.dudl(dof.index) : 0.0;
+        };
 
-        info = solver.solve(-input.dimensions.brace_height);
-        return system.get_angle(nodes_string[0], nodes_string[1]);
+        double dx = system.get_u(nodes_string[1].x) - system.get_u(nodes_string[0].x);
+        double dy = system.get_u(nodes_string[1].y) - system.get_u(nodes_string[0].y);
+        double ddx = get_dudl(nodes_string[1].x) - get_dudl(nodes_string[0].x);
+        double ddy = get_dudl(nodes_string[1].y) - get_dudl(nodes_string[0].y);
+        trial.dalpha = (dx*ddy - dy*ddx)/(dx*dx + dy*dy);
+
+        return true;
     };
 
-    // Find a element length at which the brace height difference is zero
-    // Todo: Perhaps limit the step size of the root finding algorithm to increase robustness.
+    // Find a element length at which the angle of the string center is zero by Newton's method, using the derivative of the angle
+    // from the sensitivity of the equilibrium state. The angle increases with the element length, so the steps are kept inside
+    // of the interval where the sign changes once it is known. Each trial starts from the nearest previous trial.
     double l = (points[1] - points[0]).norm();
-    if(try_element_length(l) <= 0.0)
+    std::vector<Trial> trials(1);
+    try_element_length(l, nullptr, trials[0]);
+    if(trials[0].alpha <= 0.0)
         throw std::runtime_error("Invalid input: Brace height is too low");
 
-    double dl = 1e-3*l;        // Initial step length, later adjusted by the algorithm    // Magic number
-    double dl_min = 1e-5*l;   // Minimum step length, abort if smaller                   // Magic number
-    const unsigned iterations = 5;    // Desired number of iterations for the static solver      // Magic number
-    while(true) {
-        // Try length = l - dl
-        double alpha = try_element_length(l - dl);
+    // The string is initially free of stress, so its tangent stiffness is almost singular. The solver may not converge and the
+    // sensitivities of the first trial are meaningless. Either way, start from its state with a fixed step.
+    trials[0].dalpha = 0.0;
+    trials[0].dudl = VectorXd::Zero(system.dofs());
+
+    double l_min = 0.0;    // Lower bound of the element length, angle < 0 if known
+    double l_max = l;      // Upper bound of the element length, angle > 0
+    double dl_start = 1e-3*l;    // Step length without a usable derivative     // Magic number
+    double dl_min = 1e-5*l;      // Minimum step length, abort if smaller       // Magic number
+    const unsigned max_iter = 50;    // Magic number
+
+    for(unsigned i = 0; ; ++i) {
+        const Trial& last = trials.back();
+        if(std::abs(last.alpha) < 1e-5 || l_max - l_min < 1e-10) {    // Magic numbers
+            l = last.l;
+            break;
+        }
+
+        if(i == max_iter) {
+            throw std::runtime_error("Failed to find the braced equilibrium state of the bow");
+        }
+
+        // Newton step, replaced by bisection if it leaves the bounds
+        double l_next = (last.dalpha > 0.0) ? last.l - last.alpha/last.dalpha : last.l - dl_start;
+        if(l_next <= l_min || l_next >= l_max) {
+            l_next = (l_min > 0.0) ? 0.5*(l_min + l_max) : last.l - dl_start;
+        }
+
+        // Try the step, halve it while the static solver fails
+        Trial trial;
+        while(true) {
+            auto nearest = std::min_element(trials.begin(), trials.end(), [&](const Trial& a, const Trial& b) {
+                return std::abs(a.l - l_next) < std::abs(b.l - l_next);
+            });
 
-        if(info.outcome == StaticSolverDC::Info::Success) {
-            // Success: Apply step.
-            l -= dl;
+            if(try_element_length(l_next, &*nearest, trial)) {
+                break;
+            }
 
-            // If sign change of alpha: Almost done, do the rest by root finding.
-            if(alpha <= 0.0) {
-                l = bisect<true>(try_element_length, l, l+dl, 1e-5, 1e-10, 20);    // Magic numbers
+            // Retry from the nearest trial itself, the extrapolation may be poor
+            system.set_u(nearest->u);
+            system.set_p(nearest->p);
+            if(try_element_length(l_next, nullptr, trial)) {
                 break;
             }
 
-            // Adjust step length
-            dl *= double(iterations)/info.iterations;
-        } else {
-            // Reduce step length by generic factor
-            dl *= 0.5;
+            if(std::abs(l_next - nearest->l) < dl_min) {
+                throw std::runtime_error("Failed to find the braced equilibrium state of the bow");
+            }
+
+            l_next = 0.5*(l_next + nearest->l);
         }
 
-        if(dl < dl_min) {
-            throw std::runtime_error("Failed to find the braced equilibrium state of the bow");
+        if(trial.alpha > 0.0) {
+            l_max = std::min(l_max, trial.l);
+        }
+        else {
+            l_min = std::max(l_min, trial.l);
         }
+
+        trials.push_back(trial);
     }
 
     // Set string material damping to match user defined damping ratio
@@ -221,20 +364,104 @@ BowStates BowModel::simulate_statics(const Callback& callback) {
 
     system.set_p(nodes_string[0].y, 1.0);    // Will be scaled by the static algorithm
     StaticSolverDC solver(system, nodes_string[0].y);
-    for(unsigned i = 0; i < input.settings.n_draw_steps; ++i) {
-        double eta = double(i)/(input.settings.n_draw_steps - 1);
-        double draw_length = (1.0 - eta)*input.dimensions.brace_height + eta*input.dimensions.draw_length;
 
-        solver.solve(-draw_length);
-        add_state(output);
+    // Start each draw step from a quadratic extrapolation of the previous equilibrium states
+    // and fall back to the last equilibrium state if the solver fails from there
+    PathStates states;
+    VectorXd u_predicted;
+    auto solve_draw_length = [&](double draw_length) {
+        states.predict(draw_length, 2, system);
+        u_predicted = system.get_u();
+
+        StaticSolver::Info info = solver.solve(-draw_length);
+        if(info.outcome != StaticSolver::Info::Success && states.restore(system)) {
+            info = solver.solve(-draw_length);
+        }
+
+        return info;
+    };
+
+    double draw_start = input.dimensions.brace_height;
+    double draw_end = input.dimensions.draw_length;
+    unsigned n_steps = input.settings.n_draw_steps;
+
+    if(!options.adaptive_draw_steps) {
+        for(unsigned i = 0; i < n_steps; ++i) {
+            double eta = double(i)/(n_steps - 1);
+            double draw_length = (1.0 - eta)*draw_start + eta*draw_end;
+
+            // Only equilibrium states are used for predicting the next steps
+            if(solve_draw_length(draw_length).outcome == StaticSolver::Info::Success) {
+                states.add_state(draw_length, system);
+            }
+            add_state(output);
 
-        callback(std::round(100.0*eta), 0);
+            callback(std::round(100.0*eta), 0);
+        }
+
+        return output;
     }
 
+    // Adaptive draw steps: The step length is controlled by the correction that the solver applies to the predicted state,
+    // relative to the change of the displacements over the step. Since the prediction is quadratic, the correction scales
+    // with ds^3 on smooth parts of the path. It becomes large where the path has a kink, like when contacts between limb and
+    // string begin or end, and the steps are refined there. The results are interpolated onto the output steps afterwards.
+    double ds_out = (draw_end - draw_start)/(n_steps - 1);
+    double ds_max = std::max((draw_end - draw_start)/50.0, ds_out);    // Maximum step length                     // Magic number
+    double ds_min = 1e-5*(draw_end - draw_start);                       // Minimum step length, abort if smaller   // Magic number
+    const double correction = 1e-3;    // Desired relative correction of the predicted state    // Magic number
+
+    double draw_length = draw_start;
+    double ds = std::min(ds_out, ds_max);
+
+    solve_draw_length(draw_length);
+    states.add_state(draw_length, system);
+    VectorXd u_previous = system.get_u();
+
+    while(draw_length < draw_end) {
+        double draw_next = std::min(draw_length + ds, draw_end);
+        bool quadratic = (states.size() >= 3);    // Whether the step was predicted quadratically
+        StaticSolver::Info info = solve_draw_length(draw_next);
+
+        if(info.outcome == StaticSolver::Info::Success) {
+            // Success: Apply step and adjust step length, once the prediction is quadratic
+            if(quadratic) {
+                double ratio = (system.get_u() - u_predicted).norm()/(system.get_u() - u_previous).norm();
+                ds = std::min(ds*std::clamp(std::cbrt(correction/ratio), 0.5, 2.0), ds_max);    // Magic numbers
+            }
+
+            draw_length = draw_next;
+            states.add_state(draw_length, system);
+            u_previous = system.get_u();
+
+            callback(std::round(100.0*(draw_length - draw_start)/(draw_end - draw_start)), 0);
+        }
+        else {
+            // Failure: Reduce step length by generic factor and retry from the last equilibrium state
+            states.restore(system);
+            ds *= 0.5;
+        }
+
+        if(ds < ds_min) {
+            throw std::runtime_error("Failed to find the static equilibrium states of the bow");
+        }
+    }
+
+    // Interpolate the results onto the output draw lengths with cubic polynomials
+    for(unsigned i = 0; i < n_steps; ++i) {
+        double eta = double(i)/(n_steps - 1);
+        states.interpolate((1.0 - eta)*draw_start + eta*draw_end, 3, system);
+        add_state(output);
+    }
+
+    // Leave the system in the final equilibrium state for the dynamic simulation
+    states.restore(system);
+
     return output;
 }
 
-BowStates BowModel::simulate_dynamics(const Callback& callback) {
+// If a writer is given, the states are passed to it in chunks and the returned states are empty
+BowStates BowModel::simulate_dynamics(const Callback& callback, OutputWriter* writer) {
     BowStates output;
 
     // Set draw force to zero
@@ -244,27 +471,33 @@ BowStates BowModel::simulate_dynamics(const Callback& callback) {
     double alpha = input.settings.time_span_factor;   // Time span factor, simulate until t >= alpha*T
     bool estimated = true;                            // Whether T is estimated or already known
 
-    auto condition_arrow_departure = [&] {
-        // Arrow departs the string if it has negative acceleration that exceeds the clamp force
-        return system.get_a(node_arrow.y) <= -input.settings.arrow_clamp_force/input.masses.arrow;
+    auto event_arrow_departure = [&] {
+        // Arrow departs the string if it has negative acceleration that exceeds the clamp force, i.e. when this function becomes non-negative
+        return -input.settings.arrow_clamp_force/input.masses.arrow - system.get_a(node_arrow.y);
     };
 
+    double t_p = system.get_t();              // Time and arrow travel at the previous evaluation of the stopping criterion
+    double u_p = system.get_u(node_arrow.y);
+
     auto condition_simulation_stop = [&] {
         if(estimated) {
             double ut = system.get_u(node_arrow.y);        // Current arrow travel
             double uT = -input.dimensions.brace_height;    // Arrow travel at brace height
+            double t = system.get_t();
 
             if(ut < uT) {
                 // Arrow hasn't yet reached brace height: Update estimate for T from current time and velocity
                 double v = system.get_v(node_arrow.y);
-                double t = system.get_t();
                 T = (uT - ut)/v + t;
             }
             else {
-                // Arrow has reached brace height: Set T to current time and stop estimations
-                T = system.get_t();
+                // Arrow has reached brace height: Interpolate T between the previous and the current time and stop estimations
+                T = t_p + (uT - u_p)/(ut - u_p)*(t - t_p);
                 estimated = false;
             }
+
+            t_p = t;
+            u_p = ut;
         }
 
         return system.get_t() >= alpha*T;
@@ -273,17 +506,78 @@ BowStates BowModel::simulate_dynamics(const Callback& callback) {
     auto run_solver = [&](DynamicSolver& solver) {        
         do {
             add_state(output);
+            if(writer != nullptr && output.time.size() >= writer->chunk_size()) {
+                writer->add_dynamic_states(output);
+                output = BowStates();
+            }
             callback(100, std::round(100.0*system.get_t()/(alpha*T)));
         } while(solver.step());
     };
 
-    // Determine solver timestep
-    double dt = DynamicSolver::estimate_timestep(system, input.settings.time_step_factor);
+    // Determine solver timestep, the implicit method is only limited by accuracy and uses a fixed number of steps per sampling interval
+    bool implicit = (options.integration_method == IntegrationMethod::GeneralizedAlpha);
+    double dt = implicit ? 1.0/(input.settings.sampling_rate*options.implicit_steps)
+                         : DynamicSolver::estimate_timestep(system, input.settings.time_step_factor, options.timestep_method);
+    if(options.timestep_diagnostics) {
+        double omega_exact = DynamicSolver::estimate_max_frequency(system, TimestepMethod::Eigenvalues);
+        for(auto method: {TimestepMethod::Eigenvalues, TimestepMethod::ElementBound, TimestepMethod::Gershgorin, TimestepMethod::PowerIteration}) {
+            options.timestep_diagnostics(method, DynamicSolver::estimate_max_frequency(system, method), omega_exact);
+        }
+    }
+
+    // With subcycling, the element groups are assigned to levels whose timesteps differ by powers of two,
+    // based on the frequency bound of each group. The outer timestep is then chosen such that every level is stable
+    // with its substeps. The contact has no stiffness as long as there are no contacts, so it is always placed on the fastest level.
+    std::vector<SubcyclingLevel> subcycling;
+    if(options.subcycling && !implicit) {
+        std::map<unsigned, std::vector<std::string>> levels;    // Groups by number of substeps per outer step
+        std::map<std::string, double> omega;
+        double omega_min = std::numeric_limits<double>::infinity();
+
+        for(auto& key: system.get_elements().get_keys()) {
+            if(key != "contact") {
+                omega[key] = DynamicSolver::estimate_max_frequency(system, std::vector<std::string>{key});
+                if(omega[key] > 0.0) {
+                    omega_min = std::min(omega_min, omega[key]);
+                }
+            }
+        }
+
+        for(auto& group: omega) {
+            unsigned m = (group.second > 0.0) ? std::exp2(std::ceil(std::log2(group.second/omega_min))) : 1;
+            levels[m].push_back(group.first);
+        }
+        levels.rbegin()->second.push_back("contact");
+
+        dt = std::numeric_limits<double>::infinity();
+        unsigned previous = 1;
+        for(auto& level: levels) {
+            double omega_level = DynamicSolver::estimate_max_frequency(system, level.second);
+            if(omega_level > 0.0) {
+                dt = std::min(dt, level.first*input.settings.time_step_factor*2.0/omega_level);
+            }
+            if(level.first > 1) {
+                subcycling.push_back({level.second, level.first/previous});
+            }
+            previous = level.first;
+        }
+    }
+
+    auto configure_solver = [&](DynamicSolver& solver) {
+        if(implicit) {
+            solver.set_generalized_alpha(0.8, input.settings.time_step_factor);    // Magic number
+        }
+        else if(options.adaptive_timestep) {
+            solver.set_adaptive(input.settings.time_step_factor, options.timestep_method, {"contact"});
+        }
+    };
 
     // Create and run solver for the first phase (arrow attached to the string)
     DynamicSolver solver1(system, dt, input.settings.sampling_rate, [&]{
-        return condition_arrow_departure() || condition_simulation_stop();    // Stopping criterion for the inner loop of the simulation
-    });
+        return condition_simulation_stop();    // Stopping criterion for the inner loop of the simulation
+    }, subcycling);
+    solver1.set_event(event_arrow_departure);
+    configure_solver(solver1);
     run_solver(solver1);
 
     // Create and run solver for the second phase (free arrow) if first phase wasn't stopped by the time criterion
@@ -294,10 +588,16 @@ BowStates BowModel::simulate_dynamics(const Callback& callback) {
 
         DynamicSolver solver2(system, dt, input.settings.sampling_rate, [&]{
             return condition_simulation_stop();    // Stopping criterion for the inner loop of the simulation
-        });
+        }, subcycling);
+        configure_solver(solver2);
         run_solver(solver2);
     }
 
+    if(writer != nullptr) {
+        writer->add_dynamic_states(output);
+        output = BowStates();
+    }
+
     return output;
 }
 
@@ -338,24 +638,30 @@ void BowModel::add_state(BowStates& states) const {
     states.e_kin_arrow.push_back(e_kin_arrow);
 
     // Limb and string coordinates
-    states.x_pos_limb.push_back(VectorXd(nodes_limb.size()));
-    states.y_pos_limb.push_back(VectorXd(nodes_limb.size()));
-    states.angle_limb.push_back(VectorXd(nodes_limb.size()));
+    VectorXd x_pos_limb(nodes_limb.size());
+    VectorXd y_pos_limb(nodes_limb.size());
+    VectorXd angle_limb(nodes_limb.size());
 
     for(size_t i = 0; i < nodes_limb.size(); ++i) {
-        states.x_pos_limb.back()[i] = system.get_u(nodes_limb[i].x);
-        states.y_pos_limb.back()[i] = system.get_u(nodes_limb[i].y);
-        states.angle_limb.back()[i] = system.get_u(nodes_limb[i].phi);
+        x_pos_limb[i] = system.get_u(nodes_limb[i].x);
+        y_pos_limb[i] = system.get_u(nodes_limb[i].y);
+        angle_limb[i] = system.get_u(nodes_limb[i].phi);
     }
 
-    states.x_pos_string.push_back(VectorXd(nodes_string.size()));
-    states.y_pos_string.push_back(VectorXd(nodes_string.size()));
+    VectorXd x_pos_string(nodes_string.size());
+    VectorXd y_pos_string(nodes_string.size());
 
     for(size_t i = 0; i < nodes_string.size(); ++i) {
-        states.x_pos_string.back()[i] = system.get_u(nodes_string[i].x);
-        states.y_pos_string.back()[i] = system.get_u(nodes_string[i].y);
+        x_pos_string[i] = system.get_u(nodes_string[i].x);
+        y_pos_string[i] = system.get_u(nodes_string[i].y);
     }
 
+    states.x_pos_limb.push_back(x_pos_limb);
+    states.y_pos_limb.push_back(y_pos_limb);
+    states.angle_limb.push_back(angle_limb);
+    states.x_pos_string.push_back(x_pos_string);
+    states.y_pos_string.push_back(y_pos_string);
+
     // Limb deformation
 
     VectorXd epsilon(nodes_limb.size());
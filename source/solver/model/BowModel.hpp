@@ -1,33 +1,65 @@
 #pragma once
 #include "solver/model/input/InputData.hpp"
 #include "solver/model/output/OutputData.hpp"
+#include "solver/model/output/OutputWriter.hpp"
 #include "solver/fem/System.hpp"
+#include "solver/fem/DynamicSolver.hpp"
+#include "solver/fem/elements/ContactHandler.hpp"
 #include <functional>
+#include <string>
 
 enum class SimulationMode {
     Static,
     Dynamic
 };
 
+// Numerical options of the simulation that are not part of the model file
+struct SimulationOptions {
+    bool adaptive_draw_steps = false;   // Choose the draw steps of the static simulation adaptively and interpolate the results onto n_draw_steps uniform steps
+    unsigned threads = 1;               // Number of threads for assembling the system
+    bool deterministic = false;         // Bitwise identical results regardless of the number of threads
+
+    TimestepMethod timestep_method = TimestepMethod::Automatic;     // Estimation of the highest natural frequency for the timestep
+    bool subcycling = false;                                        // Integrate the groups of elements with their own timesteps
+    bool adaptive_timestep = false;                                 // Adapt the timestep to the contacts during the simulation, not combined with subcycling
+
+    IntegrationMethod integration_method = IntegrationMethod::CentralDifference;    // Time integration of the dynamic simulation
+    unsigned implicit_steps = 4;                                                    // Timesteps of the implicit method per sampling interval, subdivided for accuracy
+
+    ContactBroadphase contact_broadphase = ContactBroadphase::SweepAndPrune;    // Finding the pairs of limb segments and string nodes that can come into contact
+
+    // Diagnostics: If set, called before the dynamic simulation with the estimate of every timestep method
+    // for the highest natural frequency and the exact value
+    std::function<void(TimestepMethod, double, double)> timestep_diagnostics;
+};
+
 class BowModel {
 public:
     using Callback = std::function<void(int, int)>;    // Progress (static, dynamic) in percent
-    static OutputData simulate(const InputData& input, SimulationMode mode, const Callback& callback);
+    static OutputData simulate(const InputData& input, SimulationMode mode, const Callback& callback, const SimulationOptions& options = {});
+
+    // Same as above, but writes the results to a file with the dynamic states passed to the writer in chunks during the simulation
+    static void simulate(const InputData& input, SimulationMode mode, const Callback& callback, OutputWriter& writer, const SimulationOptions& options = {});
+
+    // Sets the damping parameter of the beam elements in the group such that the lowest mode of the system has the damping ratio zeta.
+    // Returns the damping parameter.
+    static double tune_damping(System& system, const std::string& group, double zeta);
 
 private:
-    BowModel(const InputData& input);
+    BowModel(const InputData& input, const SimulationOptions& options);
     void init_limb(const Callback& callback, SetupData& output);
     void init_string(const Callback& callback, SetupData& output);
     void init_masses(const Callback& callback, SetupData& output);
 
     SetupData simulate_setup(const Callback& callback);
     BowStates simulate_statics(const Callback& callback);
-    BowStates simulate_dynamics(const Callback& callback);
+    BowStates simulate_dynamics(const Callback& callback, OutputWriter* writer = nullptr);
 
     void add_state(BowStates& states) const;
 
 private:
     const InputData& input;
+    const SimulationOptions& options;
 
     System system;
     std::vector<Node> nodes_limb;
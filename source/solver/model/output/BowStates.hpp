@@ -1,5 +1,5 @@
 #pragma once
-#include "solver/numerics/EigenTypes.hpp"
+#include "solver/model/output/VectorColumn.hpp"
 #include <nlohmann/json.hpp>
 #include <vector>
 
@@ -23,17 +23,45 @@ struct BowStates
     std::vector<double> e_kin_string;
     std::vector<double> e_kin_arrow;
 
-    std::vector<VectorXd> x_pos_limb;
-    std::vector<VectorXd> y_pos_limb;
-    std::vector<VectorXd> angle_limb;
+    VectorColumn x_pos_limb;
+    VectorColumn y_pos_limb;
+    VectorColumn angle_limb;
 
-    std::vector<VectorXd> x_pos_string;
-    std::vector<VectorXd> y_pos_string;
+    VectorColumn x_pos_string;
+    VectorColumn y_pos_string;
 
-    std::vector<VectorXd> epsilon;
-    std::vector<VectorXd> kappa;
+    VectorColumn epsilon;
+    VectorColumn kappa;
 };
 
+// Calls f(name, member) for every member of the states, with the same names as in the serialization below.
+// The members are either of type std::vector<double> or VectorColumn.
+template<class States, class F>
+void for_each_column(States& states, const F& f)
+{
+    f("time", states.time);
+    f("draw_length", states.draw_length);
+    f("draw_force", states.draw_force);
+    f("string_force", states.string_force);
+    f("strand_force", states.strand_force);
+    f("grip_force", states.grip_force);
+    f("pos_arrow", states.pos_arrow);
+    f("vel_arrow", states.vel_arrow);
+    f("acc_arrow", states.acc_arrow);
+    f("e_pot_limbs", states.e_pot_limbs);
+    f("e_kin_limbs", states.e_kin_limbs);
+    f("e_pot_string", states.e_pot_string);
+    f("e_kin_string", states.e_kin_string);
+    f("e_kin_arrow", states.e_kin_arrow);
+    f("x_pos_limb", states.x_pos_limb);
+    f("y_pos_limb", states.y_pos_limb);
+    f("angle_limb", states.angle_limb);
+    f("x_pos_string", states.x_pos_string);
+    f("y_pos_string", states.y_pos_string);
+    f("epsilon", states.epsilon);
+    f("kappa", states.kappa);
+}
+
 NLOHMANN_DEFINE_TYPE_NON_INTRUSIVE(
         BowStates,
         time,
@@ -0,0 +1,109 @@
+#include "MappedFile.hpp"
+#include <stdexcept>
+
+#ifdef _WIN32
+#define WIN32_LEAN_AND_MEAN
+#define NOMINMAX
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+#ifdef _WIN32
+
+MappedFile::MappedFile(const std::string& path)
+{
+    file = CreateFileA(path.c_str(), GENERIC_READ, FILE_SHARE_READ | FILE_SHARE_DELETE, nullptr, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, nullptr);
+    if(file == INVALID_HANDLE_VALUE) {
+        file = nullptr;
+        throw std::runtime_error("Failed to open file " + path);
+    }
+
+    LARGE_INTEGER file_size;
+    if(!GetFileSizeEx(file, &file_size)) {
+        CloseHandle(file);
+        throw std::runtime_error("Failed to determine the size of file " + path);
+    }
+
+    length = file_size.QuadPart;
+    if(length == 0) {
+        return;    // Empty files can't be mapped
+    }
+
+    mapping = CreateFileMappingA(file, nullptr, PAGE_READONLY, 0, 0, nullptr);
+    if(mapping == nullptr) {
+        CloseHandle(file);
+        throw std::runtime_error("Failed to map file " + path);
+    }
+
+    address = static_cast<const uint8_t*>(MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0));
+    if(address == nullptr) {
+        CloseHandle(mapping);
+        CloseHandle(file);
+        throw std::runtime_error("Failed to map file " + path);
+    }
+}
+
+MappedFile::~MappedFile()
+{
+    if(address != nullptr) {
+        UnmapViewOfFile(address);
+    }
+    if(mapping != nullptr) {
+        CloseHandle(mapping);
+    }
+    if(file != nullptr) {
+        CloseHandle(file);
+    }
+}
+
+#else
+
+MappedFile::MappedFile(const std::string& path)
+{
+    int fd = open(path.c_str(), O_RDONLY);
+    if(fd == -1) {
+        throw std::runtime_error("Failed to open file " + path);
+    }
+
+    struct stat info;
+    if(fstat(fd, &info) == -1) {
+        close(fd);
+        throw std::runtime_error("Failed to determine the size of file " + path);
+    }
+
+    length = info.st_size;
+    if(length != 0) {    // Empty files can't be mapped
+        void* result = mmap(nullptr, length, PROT_READ, MAP_PRIVATE, fd, 0);
+        if(result == MAP_FAILED) {
+            close(fd);
+            throw std::runtime_error("Failed to map file " + path);
+        }
+
+        address = static_cast<const uint8_t*>(result);
+    }
+
+    close(fd);    // The mapping remains valid after closing the file
+}
+
+MappedFile::~MappedFile()
+{
+    if(address != nullptr) {
+        munmap(const_cast<uint8_t*>(address), length);
+    }
+}
+
+#endif
+
+const uint8_t* MappedFile::data() const
+{
+    return address;
+}
+
+size_t MappedFile::size() const
+{
+    return length;
+}
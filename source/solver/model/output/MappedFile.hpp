@@ -0,0 +1,29 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <string>
+
+// Read-only memory mapping of a whole file. The operating system loads the contents on demand when they are accessed,
+// so that opening even large files is fast and only the parts that are actually used take up memory.
+// On Windows, the file can be renamed and deleted while it is mapped, but not overwritten (see ResultFile::replace).
+class MappedFile
+{
+public:
+    MappedFile(const std::string& path);
+    ~MappedFile();
+
+    MappedFile(const MappedFile&) = delete;
+    MappedFile& operator=(const MappedFile&) = delete;
+
+    const uint8_t* data() const;
+    size_t size() const;
+
+private:
+    const uint8_t* address = nullptr;
+    size_t length = 0;
+
+#ifdef _WIN32
+    void* file = nullptr;
+    void* mapping = nullptr;
+#endif
+};
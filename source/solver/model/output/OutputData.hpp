@@ -15,10 +15,10 @@ struct OutputData
     DynamicData dynamics;
 
     OutputData() = default;    // Todo: Make this one obsolete
-    OutputData(const std::string& path);
+    OutputData(const std::string& path);    // Reads the result format of ResultFile, with the vectors of the states mapped lazily, or the previous MessagePack format
     OutputData(SetupData setup, BowStates static_states, BowStates dynamic_states);
 
-    void save(const std::string& path) const;
+    void save(const std::string& path) const;    // Writes the result format of ResultFile
 };
 
 NLOHMANN_DEFINE_TYPE_NON_INTRUSIVE(OutputData, version, setup, statics, dynamics)
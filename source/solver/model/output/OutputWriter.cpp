@@ -0,0 +1,100 @@
+#include "OutputWriter.hpp"
+#include "ResultFile.hpp"
+#include <algorithm>
+#include <cstdio>
+
+OutputWriter::OutputWriter(const std::string& path, size_t chunk_size)
+    : path(path),
+      max_states(std::max(chunk_size, size_t(1))),
+      output(output_path(), std::ios::out | std::ios::binary)
+{
+    output.exceptions(~std::ofstream::goodbit);    // Make stream throw exception on failure
+}
+
+OutputWriter::~OutputWriter()
+{
+    // Remove the temporary files, including the output file if the writer didn't finish
+    for(auto& entry: series) {
+        entry.second.exceptions(std::ofstream::goodbit);
+        entry.second.close();
+        std::remove(series_path(entry.first).c_str());
+    }
+
+    if(!finished) {
+        output.exceptions(std::ofstream::goodbit);
+        output.close();
+        std::remove(output_path().c_str());
+    }
+}
+
+size_t OutputWriter::chunk_size() const
+{
+    return max_states;
+}
+
+void OutputWriter::begin(const SetupData& setup, const StaticData& statics)
+{
+    this->setup = setup;
+    this->statics = statics;
+
+    for(auto& entry: ResultFile::get_columns(BowStates())) {
+        std::ofstream& stream = series[entry.first];
+        stream.open(series_path(entry.first), std::ios::out | std::ios::binary);
+        stream.exceptions(~std::ofstream::goodbit);    // Make stream throw exception on failure
+        series_cols[entry.first] = entry.second.cols;
+    }
+
+    statistics = std::make_unique<StateStatistics>(setup.limb_properties);
+}
+
+void OutputWriter::add_dynamic_states(const BowStates& states)
+{
+    for(auto& entry: ResultFile::get_columns(states)) {
+        entry.second.write(series.at(entry.first));
+        if(entry.second.rows != 0) {
+            series_cols.at(entry.first) = entry.second.cols;
+        }
+    }
+
+    statistics->add_states(states);
+    n_states += states.time.size();
+}
+
+void OutputWriter::finish()
+{
+    DynamicData dynamics;
+    if(n_states != 0) {
+        statistics->get_dynamic_data(dynamics, statics.drawing_work);
+    }
+
+    ResultFile::Columns dynamic_columns;
+    for(auto& entry: series) {
+        entry.second.close();
+
+        std::string temporary = series_path(entry.first);
+        size_t cols = series_cols.at(entry.first);
+        dynamic_columns[entry.first] = {n_states, cols, [temporary, rows = n_states, cols](std::ostream& stream) {
+            if(rows*cols != 0) {
+                std::ifstream input(temporary, std::ios::binary);
+                input.exceptions(~std::ifstream::goodbit);    // Make stream throw exception on failure
+                stream << input.rdbuf();
+            }
+        }};
+    }
+
+    ResultFile::write(output, setup, statics, dynamics, ResultFile::get_columns(statics.states), dynamic_columns);
+    output.close();
+
+    ResultFile::replace(output_path(), path);
+    finished = true;
+}
+
+std::string OutputWriter::output_path() const
+{
+    return path + ".tmp";
+}
+
+std::string OutputWriter::series_path(const std::string& key) const
+{
+    return path + "." + key + ".tmp";
+}
@@ -0,0 +1,43 @@
+#pragma once
+#include "solver/model/output/OutputData.hpp"
+#include "solver/model/output/StateStatistics.hpp"
+#include <fstream>
+#include <map>
+#include <memory>
+#include <string>
+
+// Writes simulation results in the format of ResultFile like OutputData::save, but receives the dynamic states in chunks
+// while the simulation is running instead of keeping all of them in memory.
+//
+// Each chunk is appended to temporary files next to the output file, one per column of the states, and then discarded,
+// so that the memory usage is bounded by the chunk size. The characteristic numbers of the dynamic simulation are evaluated
+// incrementally from the chunks. finish() assembles the result file from the temporary files, without it no result is written.
+class OutputWriter
+{
+public:
+    OutputWriter(const std::string& path, size_t chunk_size = 1000);
+    ~OutputWriter();
+
+    size_t chunk_size() const;
+
+    void begin(const SetupData& setup, const StaticData& statics);
+    void add_dynamic_states(const BowStates& states);
+    void finish();
+
+private:
+    std::string path;
+    size_t max_states;
+
+    std::ofstream output;                           // Temporary output file, moved to the path when finished
+    std::map<std::string, std::ofstream> series;    // Temporary files of the dynamic states
+    std::map<std::string, size_t> series_cols;      // Number of values per state of each column
+    size_t n_states = 0;
+
+    SetupData setup;
+    StaticData statics;
+    std::unique_ptr<StateStatistics> statistics;
+    bool finished = false;
+
+    std::string output_path() const;
+    std::string series_path(const std::string& key) const;
+};
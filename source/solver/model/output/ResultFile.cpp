@@ -0,0 +1,216 @@
+#include "ResultFile.hpp"
+#include "OutputData.hpp"
+#include <nlohmann/json.hpp>
+#include <cstdio>
+#include <cstring>
+#include <stdexcept>
+
+#ifdef _WIN32
+#define WIN32_LEAN_AND_MEAN
+#define NOMINMAX
+#include <windows.h>
+#endif
+
+using nlohmann::json;
+
+static const char MAGIC[8] = {'V', 'B', 'R', 'E', 'S', 'U', 'L', 'T'};
+static const size_t PREAMBLE_SIZE = 16;    // Magic bytes, format version and header size
+
+static void write_uint32(std::ostream& stream, uint32_t value)
+{
+    char bytes[4] = { char(value), char(value >> 8), char(value >> 16), char(value >> 24) };
+    stream.write(bytes, 4);
+}
+
+static uint32_t read_uint32(const uint8_t* bytes)
+{
+    return uint32_t(bytes[0]) | uint32_t(bytes[1]) << 8 | uint32_t(bytes[2]) << 16 | uint32_t(bytes[3]) << 24;
+}
+
+static size_t align(size_t offset)
+{
+    return (offset + 7)/8*8;
+}
+
+static ResultFile::Column get_column(const std::vector<double>& column)
+{
+    return {column.size(), 1, [&column](std::ostream& stream) {
+        stream.write(reinterpret_cast<const char*>(column.data()), column.size()*sizeof(double));
+    }};
+}
+
+static ResultFile::Column get_column(const VectorColumn& column)
+{
+    return {column.size(), column.cols(), [&column](std::ostream& stream) {
+        stream.write(reinterpret_cast<const char*>(column.data()), column.size()*column.cols()*sizeof(double));
+    }};
+}
+
+// Scalar values are copied, vectors refer to the mapped file
+static void set_column(std::vector<double>& column, const double* values, size_t rows, size_t cols, const std::shared_ptr<const MappedFile>&)
+{
+    if(rows != 0 && cols != 1) {
+        throw std::runtime_error("Invalid result file, scalar column with more than one value per state");
+    }
+
+    column.assign(values, values + rows);
+}
+
+static void set_column(VectorColumn& column, const double* values, size_t rows, size_t cols, const std::shared_ptr<const MappedFile>& file)
+{
+    column = VectorColumn(values, rows, cols, file);
+}
+
+ResultFile::Columns ResultFile::get_columns(const BowStates& states)
+{
+    Columns columns;
+    for_each_column(states, [&](const std::string& name, const auto& column) {
+        columns.emplace(name, get_column(column));
+    });
+
+    return columns;
+}
+
+void ResultFile::write(std::ostream& stream, const SetupData& setup, const StaticData& statics, const DynamicData& dynamics,
+                       const Columns& static_columns, const Columns& dynamic_columns)
+{
+    // Copies of the static and dynamic data without the states. Copying the columns of vectors is cheap, since they share their values.
+    auto without_states = [](auto data) {
+        data.states = BowStates();
+        return data;
+    };
+
+    // Layout of the columns, in the same order as they are written below
+    size_t offset = 0;
+    auto get_layout = [&](const Columns& columns) {
+        json layout = json::object();
+        for(auto& entry: columns) {
+            layout[entry.first] = {{"offset", offset}, {"rows", entry.second.rows}, {"cols", entry.second.cols}};
+            offset += entry.second.rows*entry.second.cols*sizeof(double);
+        }
+        return layout;
+    };
+
+    json header = {
+        {"version", Config::APPLICATION_VERSION},
+        {"setup", setup},
+        {"statics", without_states(statics)},
+        {"dynamics", without_states(dynamics)}
+    };
+
+    header["columns"]["statics"] = get_layout(static_columns);
+    header["columns"]["dynamics"] = get_layout(dynamic_columns);
+
+    std::vector<uint8_t> bytes = json::to_msgpack(header);
+    stream.write(MAGIC, sizeof(MAGIC));
+    write_uint32(stream, FORMAT_VERSION);
+    write_uint32(stream, bytes.size());
+    stream.write(reinterpret_cast<const char*>(bytes.data()), bytes.size());
+
+    std::vector<char> padding(align(PREAMBLE_SIZE + bytes.size()) - (PREAMBLE_SIZE + bytes.size()), 0);
+    stream.write(padding.data(), padding.size());
+
+    for(auto columns: {&static_columns, &dynamic_columns}) {
+        for(auto& entry: *columns) {
+            entry.second.write(stream);
+        }
+    }
+}
+
+bool ResultFile::is_result_file(const MappedFile& file)
+{
+    return file.size() >= PREAMBLE_SIZE && std::memcmp(file.data(), MAGIC, sizeof(MAGIC)) == 0;
+}
+
+void ResultFile::read(const std::shared_ptr<const MappedFile>& file, OutputData& output)
+{
+    const uint8_t* data = file->data();
+    uint32_t version = read_uint32(data + 8);
+    uint32_t header_size = read_uint32(data + 12);
+
+    if(version > FORMAT_VERSION) {
+        throw std::runtime_error("Result file version " + std::to_string(version) + " is not supported, the newest supported version is " + std::to_string(FORMAT_VERSION));
+    }
+
+    if(PREAMBLE_SIZE + header_size > file->size()) {
+        throw std::runtime_error("Invalid result file, the header exceeds the file size");
+    }
+
+    json header = json::from_msgpack(data + PREAMBLE_SIZE, data + PREAMBLE_SIZE + header_size);
+    header.at("version").get_to(output.version);
+    header.at("setup").get_to(output.setup);
+    header.at("statics").get_to(output.statics);
+    header.at("dynamics").get_to(output.dynamics);
+
+    size_t start = align(PREAMBLE_SIZE + header_size);
+    auto read_columns = [&](const json& layout, BowStates& states) {
+        for_each_column(states, [&](const std::string& name, auto& column) {
+            if(!layout.contains(name)) {
+                return;    // Leave missing columns empty
+            }
+
+            size_t offset = layout.at(name).at("offset");
+            size_t rows = layout.at(name).at("rows");
+            size_t cols = layout.at(name).at("cols");
+
+            if(offset % sizeof(double) != 0 || start + offset + rows*cols*sizeof(double) > file->size()) {
+                throw std::runtime_error("Invalid result file, column " + name + " exceeds the file size or is misaligned");
+            }
+
+            set_column(column, reinterpret_cast<const double*>(data + start + offset), rows, cols, file);
+        });
+    };
+
+    read_columns(header.at("columns").at("statics"), output.statics.states);
+    read_columns(header.at("columns").at("dynamics"), output.dynamics.states);
+}
+
+#ifdef _WIN32
+
+// A mapped file can't be overwritten or deleted on Windows, but it can be renamed since MappedFile opens it with FILE_SHARE_DELETE.
+// The previous file is therefore moved aside, the new one takes its place and the previous one is then deleted, which is
+// completed by the system once the last mapping of it is closed. Leftovers of earlier replacements are removed on the way.
+void ResultFile::replace(const std::string& temporary, const std::string& path)
+{
+    std::string previous;
+    if(GetFileAttributesA(path.c_str()) != INVALID_FILE_ATTRIBUTES) {
+        for(unsigned i = 0; ; ++i) {
+            previous = path + ".old" + std::to_string(i);
+            DeleteFileA(previous.c_str());
+            if(MoveFileExA(path.c_str(), previous.c_str(), 0)) {
+                break;
+            }
+
+            if(i == 100) {    // Magic number
+                DeleteFileA(temporary.c_str());
+                throw std::runtime_error("Failed to write " + path);
+            }
+        }
+    }
+
+    if(!MoveFileExA(temporary.c_str(), path.c_str(), 0)) {
+        if(!previous.empty()) {
+            MoveFileExA(previous.c_str(), path.c_str(), 0);
+        }
+
+        DeleteFileA(temporary.c_str());
+        throw std::runtime_error("Failed to write " + path);
+    }
+
+    if(!previous.empty()) {
+        DeleteFileA(previous.c_str());
+    }
+}
+
+#else
+
+// Renaming replaces the previous file atomically, existing mappings of it remain valid
+void ResultFile::replace(const std::string& temporary, const std::string& path)
+{
+    if(std::rename(temporary.c_str(), path.c_str()) != 0) {
+        std::remove(temporary.c_str());
+        throw std::runtime_error("Failed to write " + path);
+    }
+}
+
+#endif
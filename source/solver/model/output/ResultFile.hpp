@@ -0,0 +1,55 @@
+#pragma once
+#include "solver/model/output/SetupData.hpp"
+#include "solver/model/output/StaticData.hpp"
+#include "solver/model/output/DynamicData.hpp"
+#include "solver/model/output/MappedFile.hpp"
+#include <functional>
+#include <map>
+#include <memory>
+#include <ostream>
+#include <string>
+
+struct OutputData;
+
+// Binary result format with the bow states stored as columns, so that a file can be memory-mapped and its states loaded lazily.
+//
+// Offset  Size  Content
+// 0       8     Magic bytes "VBRESULT"
+// 8       4     Format version
+// 12      4     Size n of the header in bytes
+// 16      n     Header: MessagePack map with version, setup, statics and dynamics like the serialization of OutputData,
+//               but with empty states, and the layout of the columns under the key "columns"
+// ...           Zero padding to a multiple of 8 bytes, followed by the data of the columns
+//
+// The columns are the members of the static and dynamic BowStates, each one a contiguous block of doubles in native byte order
+// (little endian on all supported platforms). A column of vectors is a matrix with one row per state, stored row by row.
+// The layout contains offset (relative to the start of the data, multiple of 8), rows and cols of each column by states and name.
+// Integers in the first 16 bytes are little endian.
+class ResultFile
+{
+public:
+    static const uint32_t FORMAT_VERSION = 1;
+
+    // Source of the data of a column, writes rows*cols doubles to the stream
+    struct Column {
+        size_t rows;
+        size_t cols;
+        std::function<void(std::ostream&)> write;
+    };
+
+    using Columns = std::map<std::string, Column>;
+
+    // Columns of states in memory, referring to the states
+    static Columns get_columns(const BowStates& states);
+
+    // The states of statics and dynamics are ignored, they are given by the columns instead
+    static void write(std::ostream& stream, const SetupData& setup, const StaticData& statics, const DynamicData& dynamics,
+                      const Columns& static_columns, const Columns& dynamic_columns);
+
+    // The columns of vectors of the result refer to the memory of the file instead of being copied
+    static bool is_result_file(const MappedFile& file);
+    static void read(const std::shared_ptr<const MappedFile>& file, OutputData& output);
+
+    // Moves a temporary file to its final path. Existing mappings of the previous file stay valid, also on Windows.
+    static void replace(const std::string& temporary, const std::string& path);
+};
@@ -0,0 +1,122 @@
+#include "StateStatistics.hpp"
+#include <cmath>
+
+void StateStatistics::AbsMax::add(double x, unsigned i)
+{
+    if(std::abs(x) > value) {
+        value = std::abs(x);
+        index = i;
+    }
+}
+
+void StateStatistics::StressExtrema::add(double sigma, unsigned i, unsigned j)
+{
+    if(sigma > max_value) {
+        max_value = sigma;
+        max_index = {i, j};
+    }
+    if(sigma < min_value) {
+        min_value = sigma;
+        min_index = {i, j};
+    }
+}
+
+StateStatistics::StateStatistics(const LimbProperties& limb_properties)
+    : layers(limb_properties.layers),
+      stress(limb_properties.layers.size())
+{
+
+}
+
+void StateStatistics::add_states(const BowStates& states)
+{
+    for(size_t k = 0; k < states.time.size(); ++k) {
+        unsigned i = n_states + k;    // Index in the whole sequence
+
+        draw_force.add(states.draw_force[k], i);
+        string_force.add(states.string_force[k], i);
+        grip_force.add(states.grip_force[k], i);
+
+        for(size_t l = 0; l < layers.size(); ++l) {
+            VectorXd sigma_back = layers[l].He_back*states.epsilon[k] + layers[l].Hk_back*states.kappa[k];
+            VectorXd sigma_belly = layers[l].He_belly*states.epsilon[k] + layers[l].Hk_belly*states.kappa[k];
+
+            for(int j = 0; j < layers[l].length.size(); ++j) {
+                stress[l].add(sigma_back[j], i, j);
+                stress[l].add(sigma_belly[j], i, j);
+            }
+        }
+
+        if(!departed && states.acc_arrow[k] == 0.0) {
+            departure.final_pos_arrow = states.pos_arrow[k];
+            departure.final_vel_arrow = states.vel_arrow[k];
+            departure.final_e_pot_limbs = states.e_pot_limbs[k];
+            departure.final_e_kin_limbs = states.e_kin_limbs[k];
+            departure.final_e_pot_string = states.e_pot_string[k];
+            departure.final_e_kin_string = states.e_kin_string[k];
+            departure.final_e_kin_arrow = states.e_kin_arrow[k];
+            departure.arrow_departure_index = i;
+            departed = true;
+        }
+    }
+
+    if(!states.time.empty()) {
+        if(n_states == 0) {
+            draw_length_front = states.draw_length.front();
+            e_pot_front = states.e_pot_limbs.front() + states.e_pot_string.front();
+        }
+
+        draw_length_back = states.draw_length.back();
+        draw_force_back = states.draw_force.back();
+        e_pot_back = states.e_pot_limbs.back() + states.e_pot_string.back();
+    }
+
+    n_states += states.time.size();
+}
+
+size_t StateStatistics::size() const
+{
+    return n_states;
+}
+
+void StateStatistics::get_static_data(StaticData& statics) const
+{
+    statics.final_draw_force = draw_force_back;
+    statics.drawing_work = e_pot_back - e_pot_front;
+    statics.energy_storage_factor = (e_pot_back - e_pot_front)/(0.5*(draw_length_back - draw_length_front)*draw_force_back);
+    statics.max_string_force_index = string_force.index;
+    statics.max_grip_force_index = grip_force.index;
+    statics.max_draw_force_index = draw_force.index;
+
+    for(auto& extrema: stress) {
+        statics.min_stress_value.push_back(extrema.min_value);
+        statics.min_stress_index.push_back(extrema.min_index);
+        statics.max_stress_value.push_back(extrema.max_value);
+        statics.max_stress_index.push_back(extrema.max_index);
+    }
+}
+
+void StateStatistics::get_dynamic_data(DynamicData& dynamics, double drawing_work) const
+{
+    if(departed) {
+        dynamics.final_pos_arrow = departure.final_pos_arrow;
+        dynamics.final_vel_arrow = departure.final_vel_arrow;
+        dynamics.final_e_pot_limbs = departure.final_e_pot_limbs;
+        dynamics.final_e_kin_limbs = departure.final_e_kin_limbs;
+        dynamics.final_e_pot_string = departure.final_e_pot_string;
+        dynamics.final_e_kin_string = departure.final_e_kin_string;
+        dynamics.final_e_kin_arrow = departure.final_e_kin_arrow;
+        dynamics.arrow_departure_index = departure.arrow_departure_index;
+    }
+
+    dynamics.efficiency = dynamics.final_e_kin_arrow/drawing_work;
+    dynamics.max_string_force_index = string_force.index;
+    dynamics.max_grip_force_index = grip_force.index;
+
+    for(auto& extrema: stress) {
+        dynamics.min_stress_value.push_back(extrema.min_value);
+        dynamics.min_stress_index.push_back(extrema.min_index);
+        dynamics.max_stress_value.push_back(extrema.max_value);
+        dynamics.max_stress_index.push_back(extrema.max_index);
+    }
+}
@@ -0,0 +1,58 @@
+#pragma once
+#include "solver/model/output/StaticData.hpp"
+#include "solver/model/output/DynamicData.hpp"
+#include "solver/model/LimbProperties.hpp"
+#include <limits>
+#include <utility>
+#include <vector>
+
+// Characteristic numbers of a sequence of bow states: Maximum forces, minimum and maximum stresses of each layer,
+// the energies at the first and last state and the state of arrow departure. The states can be added in several chunks,
+// so that they don't have to be kept in memory at once. The indices of the results refer to the whole sequence.
+class StateStatistics
+{
+public:
+    StateStatistics(const LimbProperties& limb_properties);
+    void add_states(const BowStates& states);
+    size_t size() const;
+
+    void get_static_data(StaticData& statics) const;
+    void get_dynamic_data(DynamicData& dynamics, double drawing_work) const;
+
+private:
+    // Index of the first state with the largest absolute value
+    struct AbsMax {
+        double value = -1.0;
+        unsigned index = 0;
+
+        void add(double x, unsigned i);
+    };
+
+    struct StressExtrema {
+        double min_value = std::numeric_limits<double>::max();
+        double max_value = std::numeric_limits<double>::lowest();
+        std::pair<unsigned, unsigned> min_index = {0, 0};
+        std::pair<unsigned, unsigned> max_index = {0, 0};
+
+        void add(double sigma, unsigned i, unsigned j);
+    };
+
+    std::vector<LayerProperties> layers;
+    size_t n_states = 0;
+
+    AbsMax draw_force;
+    AbsMax string_force;
+    AbsMax grip_force;
+    std::vector<StressExtrema> stress;
+
+    // Values at the first and the last state
+    double draw_length_front = 0.0;
+    double draw_length_back = 0.0;
+    double draw_force_back = 0.0;
+    double e_pot_front = 0.0;
+    double e_pot_back = 0.0;
+
+    // Values at arrow departure, i.e. the first state with zero arrow acceleration
+    bool departed = false;
+    DynamicData departure;
+};
@@ -0,0 +1,76 @@
+#include "VectorColumn.hpp"
+#include "MappedFile.hpp"
+#include <stdexcept>
+
+VectorColumn::VectorColumn(const double* values, size_t rows, size_t cols, std::shared_ptr<const MappedFile> file)
+    : file(std::move(file)),
+      values(values),
+      n_rows(rows),
+      n_cols(cols)
+{
+
+}
+
+void VectorColumn::push_back(const VectorXd& vector)
+{
+    if(n_rows != 0 && size_t(vector.size()) != n_cols) {
+        throw std::runtime_error("Vectors of a column must have equal size");
+    }
+
+    // Copy the values into an own buffer if they are shared with other columns or mapped from a file
+    if(buffer == nullptr || buffer.use_count() > 1) {
+        buffer = std::make_shared<std::vector<double>>(data(), data() + n_rows*n_cols);
+        file = nullptr;
+    }
+
+    buffer->insert(buffer->end(), vector.data(), vector.data() + vector.size());
+    values = buffer->data();
+    n_cols = vector.size();
+    n_rows += 1;
+}
+
+size_t VectorColumn::size() const
+{
+    return n_rows;
+}
+
+size_t VectorColumn::cols() const
+{
+    return n_cols;
+}
+
+bool VectorColumn::empty() const
+{
+    return n_rows == 0;
+}
+
+Eigen::Map<const VectorXd> VectorColumn::operator[](size_t i) const
+{
+    return Eigen::Map<const VectorXd>(values + i*n_cols, n_cols);
+}
+
+Eigen::Map<const VectorColumn::RowMatrixXd> VectorColumn::matrix() const
+{
+    return Eigen::Map<const RowMatrixXd>(values, n_rows, n_cols);
+}
+
+const double* VectorColumn::data() const
+{
+    return values;
+}
+
+void to_json(nlohmann::json& object, const VectorColumn& column)
+{
+    object = nlohmann::json::array();
+    for(size_t i = 0; i < column.size(); ++i) {
+        object.push_back(VectorXd(column[i]));
+    }
+}
+
+void from_json(const nlohmann::json& object, VectorColumn& column)
+{
+    column = VectorColumn();
+    for(auto& vector: object) {
+        column.push_back(vector.get<VectorXd>());
+    }
+}
@@ -0,0 +1,41 @@
+#pragma once
+#include "solver/numerics/EigenTypes.hpp"
+#include "solver/numerics/EigenSerialize.hpp"
+#include <nlohmann/json.hpp>
+#include <memory>
+#include <vector>
+
+class MappedFile;
+
+// Sequence of vectors with equal size, e.g. one vector of nodal values per state. The values are stored contiguously
+// as the rows of a matrix with one row per vector, either in an own buffer or in the memory of a mapped result file.
+// Copies share the values, a shared buffer is only copied when vectors are added (copy on write).
+class VectorColumn
+{
+public:
+    using RowMatrixXd = Eigen::Matrix<double, Eigen::Dynamic, Eigen::Dynamic, Eigen::RowMajor>;
+
+    VectorColumn() = default;
+    VectorColumn(const double* values, size_t rows, size_t cols, std::shared_ptr<const MappedFile> file);    // View of a mapped file
+
+    void push_back(const VectorXd& vector);
+
+    size_t size() const;    // Number of vectors
+    size_t cols() const;    // Size of each vector
+    bool empty() const;
+
+    Eigen::Map<const VectorXd> operator[](size_t i) const;
+    Eigen::Map<const RowMatrixXd> matrix() const;
+    const double* data() const;
+
+private:
+    std::shared_ptr<std::vector<double>> buffer;    // Own values, if any
+    std::shared_ptr<const MappedFile> file;         // Mapped file that contains the values, if any
+    const double* values = nullptr;
+    size_t n_rows = 0;
+    size_t n_cols = 0;
+};
+
+// Serialized as an array of vectors
+void to_json(nlohmann::json& object, const VectorColumn& column);
+void from_json(const nlohmann::json& object, VectorColumn& column);
@@ -0,0 +1,50 @@
+#pragma once
+#include "EigenTypes.hpp"
+#include <cmath>
+
+// Elementwise math functions on arrays that are written as Eigen array expressions without branches,
+// so that they can be vectorized. Eigen 3.4 doesn't provide vectorized versions of these for double.
+
+// Arc tangent of y/x in [-pi, pi] like std::atan2, accurate to a few ulp. The result is written to a, the array r is used as workspace.
+// Both are only resized if their size doesn't match, so that repeated calls don't allocate.
+// Range reduction to [0, 1] by symmetry and rational approximation of the Cephes library [1] on [0, 0.66] and (0.66, 1].
+// [1] https://www.netlib.org/cephes/, atan.c
+inline void array_atan2(const ArrayXd& y, const ArrayXd& x, ArrayXd& a, ArrayXd& r)
+{
+    const double P0 = -8.750608600031904122785e-1;
+    const double P1 = -1.615753718733365076637e1;
+    const double P2 = -7.500855792314704667340e1;
+    const double P3 = -1.228866684490136173410e2;
+    const double P4 = -6.485021904942025371773e1;
+
+    const double Q1 = 2.485846490142306297962e1;
+    const double Q2 = 1.650270098316988542046e2;
+    const double Q3 = 4.328810604912902668951e2;
+    const double Q4 = 4.853903996359136964868e2;
+    const double Q5 = 1.945506571482613964425e2;
+
+    const double more_bits = 6.123233995736765886130e-17;    // Lower part of pi/2 in double precision
+
+    auto ax = x.abs();
+    auto ay = y.abs();
+
+    // Argument t = min/max in [0, 1], stored in a and shifted to r = (t - 1)/(t + 1) for t > 0.66
+    a = (ax.max(ay) > 0.0).select(ax.min(ay)/ax.max(ay), 0.0);
+    r = (a > 0.66).select((a - 1.0)/(a + 1.0), a);
+
+    auto z = r.square();
+    auto p = (((P0*z + P1)*z + P2)*z + P3)*z + P4;
+    auto q = ((((z + Q1)*z + Q2)*z + Q3)*z + Q4)*z + Q5;
+    a = r + r*z*p/q + (a > 0.66).cast<double>()*(0.25*M_PI + 0.5*more_bits);    // Elementwise, a may appear on both sides
+
+    // Undo the range reduction
+    a = (ay > ax).select((0.5*M_PI - a) + more_bits, a);
+    a = (x < 0.0).select((M_PI - a) + 2.0*more_bits, a);
+    a = (y < 0.0).select(-a, a);
+}
+
+// Maps angles onto [-pi/2, pi/2] in place, which is the same as atan(sin(phi)/cos(phi))
+inline void array_wrap_half(ArrayXd& phi)
+{
+    phi -= M_PI*(phi/M_PI).round();
+}
@@ -0,0 +1,108 @@
+#pragma once
+#include "EigenTypes.hpp"
+#include <algorithm>
+#include <cassert>
+#include <cmath>
+
+// LDL^T decomposition of a symmetric band matrix without pivoting.
+// Only the lower band of the matrix is stored, column by column: band(i - j, j) = A(i, j) for 0 <= i - j <= bandwidth.
+// The factorization is done in place, which takes O(n*b^2) operations for a matrix of size n and bandwidth b.
+// https://en.wikipedia.org/wiki/Band_matrix
+
+class BandedLDLT
+{
+public:
+    BandedLDLT()
+        : n(0), b(0)
+    {
+
+    }
+
+    size_t size() const {
+        return n;
+    }
+
+    size_t bandwidth() const {
+        return b;
+    }
+
+    // Sets the dimensions and all entries to zero
+    void resize(size_t size, size_t bandwidth) {
+        n = size;
+        b = std::min(bandwidth, (n > 0) ? n - 1 : 0);
+        band.setZero(b + 1, n);
+    }
+
+    void set_zero() {
+        band.setZero();
+    }
+
+    // Entry of the lower band, i >= j and i - j <= bandwidth
+    double& at(size_t i, size_t j) {
+        assert(i >= j && i - j <= b);
+        return band(i - j, j);
+    }
+
+    // Replaces the band with the factors L (below the diagonal, unit diagonal implied) and D (on the diagonal).
+    // Returns false if a zero pivot is encountered.
+    bool factorize() {
+        for(size_t j = 0; j < n; ++j) {
+            size_t k0 = (j > b) ? j - b : 0;
+
+            // Diagonal entry d_j = A(j, j) - sum_k L(j, k)^2*d_k
+            double d = band(0, j);
+            for(size_t k = k0; k < j; ++k) {
+                d -= band(j - k, k)*band(j - k, k)*band(0, k);
+            }
+
+            if(d == 0.0 || !std::isfinite(d)) {
+                return false;
+            }
+
+            band(0, j) = d;
+
+            // Column j of L, L(i, j) = (A(i, j) - sum_k L(i, k)*L(j, k)*d_k)/d_j
+            size_t i1 = std::min(n - 1, j + b);
+            for(size_t i = j + 1; i <= i1; ++i) {
+                double l = band(i - j, j);
+                for(size_t k = (i > b) ? i - b : 0; k < j; ++k) {
+                    l -= band(i - k, k)*band(j - k, k)*band(0, k);
+                }
+                band(i - j, j) = l/d;
+            }
+        }
+
+        return true;
+    }
+
+    // Solves A*x = rhs with the factorized matrix, the solution overwrites rhs
+    void solve(Eigen::Ref<VectorXd> x) const {
+        assert(size_t(x.size()) == n);
+
+        // Forward substitution L*z = rhs
+        for(size_t j = 0; j < n; ++j) {
+            size_t i1 = std::min(n - 1, j + b);
+            for(size_t i = j + 1; i <= i1; ++i) {
+                x(i) -= band(i - j, j)*x(j);
+            }
+        }
+
+        // Diagonal D*y = z
+        for(size_t j = 0; j < n; ++j) {
+            x(j) /= band(0, j);
+        }
+
+        // Backward substitution L^T*x = y
+        for(size_t j = n; j-- > 0;) {
+            size_t i1 = std::min(n - 1, j + b);
+            for(size_t i = j + 1; i <= i1; ++i) {
+                x(j) -= band(i - j, j)*x(i);
+            }
+        }
+    }
+
+private:
+    size_t n;
+    size_t b;
+    MatrixXd band;
+};
@@ -0,0 +1,17 @@
+#pragma once
+#include <cstddef>
+
+// Value of the k-th Lagrange basis polynomial on the nodes map(data[first]), ..., map(data[last - 1]) at the given argument.
+// The nodes have to be distinct. https://en.wikipedia.org/wiki/Lagrange_polynomial
+template<typename C, typename F>
+inline double lagrange_basis(const C& data, const F& map, size_t first, size_t last, size_t k, double value)
+{
+    double result = 1.0;
+    for(size_t m = first; m < last; ++m) {
+        if(m != k) {
+            result *= (value - map(data[m]))/(map(data[k]) - map(data[m]));
+        }
+    }
+
+    return result;
+}
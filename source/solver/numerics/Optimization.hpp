@@ -30,3 +30,24 @@ inline double golden_section_search(const F& f, double xa, double xb, double xto
 
     throw std::runtime_error("Golden section search: Maximum number of iterations exceeded");
 }
+
+// Backtracking line search for a step length eta in (0, 1] that satisfies the sufficient decrease condition
+// f(eta) <= (1 - c*eta)*f0 (Armijo condition) for a non-negative merit function f with f(0) = f0.
+// The full step eta = 1 is tried first and then reduced by the given factor. If no acceptable step is found
+// within the maximum number of iterations, the last (smallest) step length is returned.
+// https://en.wikipedia.org/wiki/Backtracking_line_search
+
+template<class F>
+inline double backtracking_search(const F& f, double f0, double c, double factor, unsigned iter) {
+    double eta = 1.0;
+    for(unsigned i = 1; i < iter; ++i) {
+        if(f(eta) <= (1.0 - c*eta)*f0) {
+            return eta;
+        }
+
+        eta *= factor;
+    }
+
+    f(eta);
+    return eta;
+}
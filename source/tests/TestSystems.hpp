@@ -0,0 +1,120 @@
+#pragma once
+#include "solver/fem/System.hpp"
+#include "solver/fem/elements/BarElement.hpp"
+#include "solver/fem/elements/BeamElement.hpp"
+#include "solver/fem/elements/MassElement.hpp"
+#include "solver/fem/elements/ContactHandler.hpp"
+#include <cmath>
+#include <vector>
+
+// Curved beam of n elements, fixed at its first node, with a string of two bar elements attached to both ends and a mass
+// at the center of the string. The elements are added to the groups "beams", "string" and "masses".
+// Mass and stiffness vary along the beam, so that the system has no special symmetries.
+struct BeamWithString
+{
+    std::vector<Node> nodes;    // Nodes of the beam
+    Node node_string;           // Center of the string
+};
+
+inline BeamWithString create_beam_with_string(System& system, size_t n, double y_string = -0.2)
+{
+    BeamWithString result;
+    for(size_t i = 0; i < n + 1; ++i) {
+        double s = double(i)/n;
+        bool active = (i != 0);
+        result.nodes.push_back(system.create_node({active, active, active}, {s, 0.4*s*s, 0.4*s}));
+    }
+
+    for(size_t i = 0; i < n; ++i) {
+        double s = double(i)/n;
+        BeamElement element(system, result.nodes[i], result.nodes[i+1], 0.5 + 0.5*s, 1.0/n);
+        element.set_reference_angles(0.01*s, -0.01*s);
+        element.set_stiffness(5000.0 - 2000.0*s, 2.0, 0.1);
+        element.set_damping(0.1);
+        system.mut_elements().add(element, "beams");
+    }
+
+    result.node_string = system.create_node({true, true, false}, {0.5, y_string, 0.0});
+    system.mut_elements().add(BarElement(system, result.nodes.front(), result.node_string, 0.5, 500.0, 0.1, 0.01), "string");
+    system.mut_elements().add(BarElement(system, result.node_string, result.nodes.back(), 0.6, 500.0, 0.1, 0.01), "string");
+    system.mut_elements().add(MassElement(system, result.node_string, 0.01), "masses");
+
+    return result;
+}
+
+// Straight cantilever beam of length L along the x axis with n elements, clamped at its first node.
+// Returns the nodes of the beam, the last one is the tip.
+inline std::vector<Node> create_cantilever(System& system, size_t n, double L, double EA, double EI)
+{
+    std::vector<Node> nodes;
+    for(size_t i = 0; i < n + 1; ++i) {
+        bool active = (i != 0);
+        nodes.push_back(system.create_node({active, active, active}, {double(i)/n*L, 0.0, 0.0}));
+    }
+
+    for(size_t i = 0; i < n; ++i) {
+        BeamElement element(system, nodes[i], nodes[i+1], 0.0, L/n);
+        element.set_stiffness(EA, EI, 0.0);
+        system.mut_elements().add(element);
+    }
+
+    return nodes;
+}
+
+// Contact between a string of n_points free points and a fixed limb of n_segments contact segments along a circular arc
+// of radius one. The contact handler is added to the group "contact", the displacements of the points come from get_string_state.
+inline void create_limb_and_string(System& system, size_t n_segments, size_t n_points, ContactBroadphase broadphase)
+{
+    ContactHandler contact(system, ContactForce(1000.0, 0.01), broadphase);
+
+    std::vector<Node> limb;
+    for(size_t i = 0; i < n_segments + 1; ++i) {
+        double phi = 1.5*i/n_segments;
+        limb.push_back(system.create_node({false, false, false}, {std::sin(phi), 1.0 - std::cos(phi), phi}));
+    }
+    for(size_t i = 0; i < n_segments; ++i) {
+        contact.add_segment(limb[i], limb[i+1], 0.02, 0.02);
+    }
+    for(size_t j = 0; j < n_points; ++j) {
+        contact.add_point(system.create_node({true, true, false}, {0.0, 0.0, 0.0}));
+    }
+
+    system.mut_elements().add(contact, "contact");
+}
+
+// Displacements of the string points on a circle slightly inside of the limb, with a wave-shaped radial offset
+// so that some points are in contact and others are not. Varying the phase moves the contacts along the string.
+inline VectorXd get_string_state(size_t n_points, double phase, double wavenumber)
+{
+    VectorXd u(2*n_points);
+    for(size_t j = 0; j < n_points; ++j) {
+        double phi = 1.5*j/(n_points - 1);
+        double r = 1.0 - 0.01 + 0.03*std::sin(phase - wavenumber*j);    // Magic numbers
+        u(2*j) = r*std::sin(phi);
+        u(2*j + 1) = 1.0 - r*std::cos(phi);
+    }
+
+    return u;
+}
+
+// Row of n fixed contact segments of length 0.1 along the x axis and a single free point at the origin, which is moved across
+// the segments by setting its displacements (the first two dofs of the system). The contact handler is added to the group "contact".
+// Returns the node of the point.
+inline Node create_segment_row(System& system, size_t n)
+{
+    ContactHandler contact(system, ContactForce(1000.0, 0.01));
+
+    std::vector<Node> nodes;
+    for(size_t i = 0; i < n + 1; ++i) {
+        nodes.push_back(system.create_node({false, false, false}, {0.1*i, 0.0, 0.0}));
+    }
+    for(size_t i = 0; i < n; ++i) {
+        contact.add_segment(nodes[i], nodes[i+1], 0.02, 0.02);
+    }
+
+    Node point = system.create_node({true, true, false}, {0.0, 0.0, 0.0});
+    contact.add_point(point);
+    system.mut_elements().add(contact, "contact");
+
+    return point;
+}
@@ -0,0 +1,126 @@
+#include "solver/fem/DynamicSolver.hpp"
+#include "solver/fem/elements/ContactHandler.hpp"
+#include "tests/TestSystems.hpp"
+#include <catch2/catch.hpp>
+#include <atomic>
+#include <cerrno>
+#include <cstdlib>
+#include <functional>
+
+// Counts the heap allocations of the process by replacing the allocation functions of the C library, which are also used
+// by operator new and by Eigen. Therefore these tests are built as an executable of their own, see CMakeLists.txt.
+// Only available with glibc, which exports the original functions as __libc_*, and not with AddressSanitizer, which
+// replaces the same functions.
+#if defined(__GLIBC__) && !defined(__SANITIZE_ADDRESS__)
+
+static std::atomic<size_t> allocations{0};
+
+extern "C" {
+    void* __libc_malloc(size_t size);
+    void* __libc_calloc(size_t n, size_t size);
+    void* __libc_realloc(void* ptr, size_t size);
+    void* __libc_memalign(size_t alignment, size_t size);
+
+    void* malloc(size_t size) noexcept {
+        ++allocations;
+        return __libc_malloc(size);
+    }
+
+    void* calloc(size_t n, size_t size) noexcept {
+        ++allocations;
+        return __libc_calloc(n, size);
+    }
+
+    void* realloc(void* ptr, size_t size) noexcept {
+        ++allocations;
+        return __libc_realloc(ptr, size);
+    }
+
+    void* memalign(size_t alignment, size_t size) noexcept {
+        ++allocations;
+        return __libc_memalign(alignment, size);
+    }
+
+    void* aligned_alloc(size_t alignment, size_t size) noexcept {
+        ++allocations;
+        return __libc_memalign(alignment, size);
+    }
+
+    int posix_memalign(void** ptr, size_t alignment, size_t size) noexcept {
+        if(alignment % sizeof(void*) != 0 || (alignment & (alignment - 1)) != 0) {
+            return EINVAL;
+        }
+
+        ++allocations;
+        void* result = __libc_memalign(alignment, size);
+        if(result == nullptr) {
+            return ENOMEM;
+        }
+
+        *ptr = result;
+        return 0;
+    }
+}
+
+TEST_CASE("dynamic-solver-allocations")
+{
+    // Curved beam with a string and masses, integrated by the central difference method without and with event
+    // detection. After a few steps for warming up (buffers, element batches) no more heap allocations must happen.
+
+    auto count_allocations = [](const std::function<void(System&, DynamicSolver&)>& configure) {
+        System system(MatrixStorage::Sparse);
+        create_beam_with_string(system, 20);
+
+        double dt = DynamicSolver::estimate_timestep(system, 0.5);
+        DynamicSolver solver(system, dt, 0.1/dt, [&]{ return false; });
+        configure(system, solver);
+
+        for(size_t i = 0; i < 10; ++i) {
+            solver.step();
+        }
+
+        size_t before = allocations;
+        for(size_t i = 0; i < 100; ++i) {
+            solver.step();
+        }
+
+        return allocations - before;
+    };
+
+    size_t plain = count_allocations([](System&, DynamicSolver&) { });
+    REQUIRE(plain == 0);
+
+    size_t event = count_allocations([](System& system, DynamicSolver& solver) {
+        solver.set_event([&]{ return system.get_t() - 1.0; });
+    });
+    REQUIRE(event == 0);
+}
+
+TEST_CASE("contact-handler-allocations")
+{
+    // A point moving back and forth across a row of contact segments repeatedly activates and deactivates contacts.
+    // After the first evaluation this must not allocate memory anymore.
+
+    System system;
+    create_segment_row(system, 10);
+
+    VectorXd u = system.get_u();
+    auto evaluate = [&](size_t i) {
+        u(0) = 0.5 + 0.5*std::sin(0.1*i);
+        u(1) = 0.03*std::cos(0.7*i);    // Magic numbers, in and out of contact several times
+        system.set_u(u);
+        system.get_q();
+        system.get_K();
+    };
+
+    evaluate(0);
+
+    size_t before = allocations;
+    for(size_t i = 1; i < 200; ++i) {
+        evaluate(i);
+    }
+
+    REQUIRE(allocations - before == 0);
+}
+
+#endif
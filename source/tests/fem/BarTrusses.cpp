@@ -88,3 +88,46 @@ TEST_CASE("large-deformation-bar-truss")
         REQUIRE(std::abs(f_num - f_ref) < 1e-9);
     }
 }
+
+TEST_CASE("bar-truss-sensitivity")
+{
+    // Unsymmetric two-bar truss under displacement control. The sensitivity of the equilibrium state with respect to the length
+    // of one bar has to match the finite difference of the equilibrium states, with the controlled displacement unchanged.
+
+    double H = 1.0;
+    double EA = 10000.0;
+
+    System system;
+
+    Node node01 = system.create_node({false, false, false}, {  0.0, 0.0, 0.0});
+    Node node02 = system.create_node({ true,  true, false}, {    H,   H, 0.0});
+    Node node03 = system.create_node({false, false, false}, {2.0*H, 0.0, 0.0});
+
+    system.mut_elements().add(BarElement(system, node01, node02, M_SQRT2*H, EA, 0.0, 0.0), "left");
+    system.mut_elements().add(BarElement(system, node02, node03, M_SQRT2*H, EA, 0.0, 0.0), "right");
+
+    system.set_p(node02.y, 1.0);
+    StaticSolverDC solver(system, node02.y);
+
+    auto solve = [&](double L) {
+        system.mut_elements().front<BarElement>("right").set_length(L);
+        REQUIRE(solver.solve(0.8*H).outcome == StaticSolver::Info::Success);
+        return system.get_u();
+    };
+
+    double L = 1.1*H;    // Magic number, shorter than the initial distance
+    double h = 1e-6;
+
+    // Derivative of the internal forces at constant displacements
+    solve(L);
+    VectorXd q = system.get_q();
+    system.mut_elements().front<BarElement>("right").set_length(L + h);
+    VectorXd dqdl = (system.get_q() - q)/h;
+    system.mut_elements().front<BarElement>("right").set_length(L);
+
+    VectorXd dudl_num = solver.get_sensitivity(dqdl);
+    VectorXd dudl_ref = (solve(L + h) - solve(L - h))/(2.0*h);
+
+    REQUIRE(std::abs(dudl_num(node02.x.index) - dudl_ref(node02.x.index)) < 1e-4*std::abs(dudl_ref(node02.x.index)));
+    REQUIRE(std::abs(dudl_num(node02.y.index)) < 1e-9);
+}
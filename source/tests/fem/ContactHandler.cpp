@@ -0,0 +1,138 @@
+#include "solver/fem/System.hpp"
+#include "solver/fem/DynamicSolver.hpp"
+#include "tests/TestSystems.hpp"
+#include "solver/fem/elements/ContactHandler.hpp"
+#include "solver/fem/elements/MassElement.hpp"
+#include <catch2/catch.hpp>
+
+TEST_CASE("contact-handler-caching")
+{
+    // A point is moved across a row of contact segments. The broadphase must run only once per change of the displacements,
+    // even though both internal forces and tangent stiffness are evaluated, and the results must be the same as those of
+    // a new contact handler that starts from scratch at each position.
+
+    System system;
+    create_segment_row(system, 10);
+    bool touched = false;
+    auto& contact = system.mut_elements().front<ContactHandler>("contact");
+
+    for(size_t i = 0; i < 20; ++i) {
+        VectorXd u = system.get_u();
+        u(0) = 0.05*i;
+        u(1) = 0.05 - 0.004*i;    // Magic number, passes through the segments
+        system.set_u(u);
+
+        VectorXd q = system.get_q();
+        MatrixXd K = system.get_K().to_dense();
+
+        REQUIRE(contact.get_counters().force_calls == i + 1);
+        REQUIRE(contact.get_counters().stiffness_calls == i + 1);
+        REQUIRE(contact.get_counters().broadphase_updates == i + 1);
+
+        System reference;
+        create_segment_row(reference, 10);
+        reference.set_u(u);
+
+        REQUIRE(q == reference.get_q());
+        REQUIRE(K == reference.get_K().to_dense());
+
+        touched = touched || (q.norm() > 0.0);
+    }
+
+    REQUIRE(touched);
+
+    contact.reset_counters();
+    REQUIRE(contact.get_counters().broadphase_updates == 0);
+}
+
+TEST_CASE("contact-handler-forces")
+{
+    // The contact forces of the handler, evaluated for its active contacts only, must agree up to rounding with those
+    // of individual contact elements for all pairs of segments and points, with the same potential energy.
+
+    auto create_nodes = [](System& system, std::vector<Node>& nodes, std::vector<Node>& points) {
+        for(size_t i = 0; i < 11; ++i) {
+            nodes.push_back(system.create_node({true, true, true}, {0.1*i, 0.01*std::sin(3.0*i), 0.1*std::cos(2.0*i)}));
+        }
+        for(size_t j = 0; j < 8; ++j) {
+            points.push_back(system.create_node({true, true, false}, {0.13*j, 0.04*std::cos(5.0*j), 0.0}));    // Magic numbers, some of them in contact
+        }
+    };
+
+    System system_handler;
+    std::vector<Node> nodes, points;
+    create_nodes(system_handler, nodes, points);
+
+    ContactHandler contact(system_handler, ContactForce(1000.0, 0.01));
+    for(size_t i = 0; i < 10; ++i) {
+        contact.add_segment(nodes[i], nodes[i+1], 0.02, 0.03);
+    }
+    for(auto& point: points) {
+        contact.add_point(point);
+    }
+    system_handler.mut_elements().add(contact, "contact");
+
+    System system_elements;
+    nodes.clear();
+    points.clear();
+    create_nodes(system_elements, nodes, points);
+
+    for(size_t i = 0; i < 10; ++i) {
+        for(auto& point: points) {
+            system_elements.mut_elements().add(ContactElement(system_elements, nodes[i], nodes[i+1], point, 0.02, 0.03, ContactForce(1000.0, 0.01)), "contact");
+        }
+    }
+
+    REQUIRE(system_handler.get_q().norm() > 0.0);
+    REQUIRE((system_handler.get_q() - system_elements.get_q()).norm() <= 1e-14*system_elements.get_q().norm());
+    REQUIRE(system_handler.get_elements().get_potential_energy("contact") == Approx(system_elements.get_elements().get_potential_energy("contact")).epsilon(1e-14));
+}
+
+TEST_CASE("contact-handler-broadphases")
+{
+    // A string wrapping onto and lifting off a curved limb. Both broadphase methods must find the same contacts
+    // and therefore give the same contact forces.
+
+    System system_sap;
+    System system_chain;
+    create_limb_and_string(system_sap, 30, 40, ContactBroadphase::SweepAndPrune);
+    create_limb_and_string(system_chain, 30, 40, ContactBroadphase::ChainWindow);
+
+    for(size_t k = 0; k < 50; ++k) {
+        VectorXd u = get_string_state(40, 0.3*k, 0.2);    // Magic numbers
+        system_sap.set_u(u);
+        system_chain.set_u(u);
+
+        REQUIRE(system_sap.get_q().norm() > 0.0);
+        REQUIRE(system_sap.get_q() == system_chain.get_q());
+    }
+}
+
+TEST_CASE("contact-handler-implicit")
+{
+    // A point mass hits the row of contact segments from below and bounces off. The contact is elastic, so the point must
+    // leave it with the opposite velocity. The implicit method is used with timesteps that are longer than the whole contact,
+    // which has to be resolved by subdividing the steps.
+
+    for(double dt: {0.005, 0.02}) {
+        System system;
+        Node point = create_segment_row(system, 10);
+        system.mut_elements().add(MassElement(system, point, 0.001));
+
+        VectorXd u = system.get_u();
+        VectorXd v = system.get_v();
+        u(point.x.index) = 0.55;    // Magic numbers
+        u(point.y.index) = -0.05;
+        v(point.y.index) = 1.0;
+        system.set_u(u);
+        system.set_v(v);
+
+        DynamicSolver solver(system, dt, 1.0/dt, [&]{ return system.get_t() >= 0.1; });
+        solver.set_generalized_alpha(0.8, 0.5);
+        while(solver.step());
+
+        REQUIRE(system.get_u(point.y) < -0.02);
+        REQUIRE(system.get_v(point.x) == Approx(0.0).margin(1e-6));
+        REQUIRE(system.get_v(point.y) == Approx(-1.0).epsilon(1e-2));
+    }
+}
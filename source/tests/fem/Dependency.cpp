@@ -0,0 +1,66 @@
+#include "solver/fem/Dependency.hpp"
+#include <catch2/catch.hpp>
+
+// Graph of the form a -> c <- b, c -> d, with counters for the number of updates
+class Graph {
+public:
+    Independent<double> a{1.0};
+    Independent<double> b{2.0};
+    mutable Dependent<double> c;
+    mutable Dependent<double> d;
+
+    mutable unsigned updates_c = 0;
+    mutable unsigned updates_d = 0;
+
+    Graph() {
+        c.depends_on(a, b);
+        c.on_update<Graph, &Graph::update_c>(this);
+
+        d.depends_on(c);
+        d.on_update<Graph, &Graph::update_d>(this);
+    }
+
+private:
+    void update_c() const {
+        c.mut() = a.get() + b.get();
+        ++updates_c;
+    }
+
+    void update_d() const {
+        d.mut() = 2.0*c.get();
+        ++updates_d;
+    }
+};
+
+TEST_CASE("dependency-invalidation")
+{
+    Graph graph;
+
+    // Values are computed lazily and only once
+    REQUIRE(graph.updates_c == 0);
+    REQUIRE(graph.d.get() == 6.0);
+    REQUIRE(graph.d.get() == 6.0);
+    REQUIRE(graph.c.get() == 3.0);
+    REQUIRE(graph.updates_c == 1);
+    REQUIRE(graph.updates_d == 1);
+
+    // Modifying an independent value invalidates the direct and indirect dependents
+    graph.a.mut() = 2.0;
+    REQUIRE(!graph.c.is_valid());
+    REQUIRE(graph.d.get() == 8.0);
+    REQUIRE(graph.updates_c == 2);
+    REQUIRE(graph.updates_d == 2);
+
+    // Modifying a dependent value directly invalidates its dependents only
+    graph.c.mut() = 10.0;
+    REQUIRE(graph.d.get() == 20.0);
+    REQUIRE(graph.c.get() == 10.0);
+    REQUIRE(graph.updates_c == 2);
+    REQUIRE(graph.updates_d == 3);
+
+    // Explicit invalidation
+    graph.d.set_valid(false);
+    REQUIRE(graph.d.get() == 20.0);
+    REQUIRE(graph.updates_c == 2);
+    REQUIRE(graph.updates_d == 4);
+}
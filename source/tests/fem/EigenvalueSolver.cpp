@@ -0,0 +1,97 @@
+#include "solver/fem/System.hpp"
+#include "solver/fem/EigenvalueSolver.hpp"
+#include "solver/fem/elements/BeamElement.hpp"
+#include "solver/fem/elements/MassElement.hpp"
+#include <Eigen/Eigenvalues>
+#include <catch2/catch.hpp>
+
+TEST_CASE("eigenvalues-damped-cantilever")
+{
+    // Lowest and highest mode of a damped cantilever beam, compared to the full solution of the
+    // equivalent linear eigenvalue problem A*z = lambda*B*z with A = [0, K; K, D], B = [K, 0; 0, -M]
+
+    System system(MatrixStorage::Sparse);
+
+    std::vector<Node> nodes;
+    for(size_t i = 0; i < 11; ++i) {
+        bool active = (i != 0);
+        nodes.push_back(system.create_node({active, active, active}, {0.1*i, 0.002*i*i, 0.04*i}));
+    }
+
+    for(size_t i = 0; i < 10; ++i) {
+        BeamElement element(system, nodes[i], nodes[i+1], 0.5, 0.1);
+        element.set_reference_angles(0.0, 0.0);
+        element.set_stiffness(5000.0, 2.0, 0.1);
+        element.set_damping(0.05);
+        system.mut_elements().add(element);
+    }
+
+    system.mut_elements().add(MassElement(system, nodes.back(), 0.2, 0.001));
+
+    size_t n = system.dofs();
+    MatrixXd A = MatrixXd::Zero(2*n, 2*n);
+    MatrixXd B = MatrixXd::Zero(2*n, 2*n);
+    system.get_K().copy_to(A.topRightCorner(n, n));
+    system.get_K().copy_to(A.bottomLeftCorner(n, n));
+    system.get_D().copy_to(A.bottomRightCorner(n, n));
+    system.get_K().copy_to(B.topLeftCorner(n, n));
+    B.bottomRightCorner(n, n) = -system.get_M().asDiagonal().toDenseMatrix();
+
+    Eigen::GeneralizedEigenSolver<MatrixXd> reference(A, B, false);
+    std::vector<ModeInfo> modes;
+    for(int i = 0; i < reference.eigenvalues().size(); ++i) {
+        if(reference.eigenvalues()[i].imag() > 0.0) {
+            modes.push_back(ModeInfo(reference.eigenvalues()[i]));
+        }
+    }
+
+    auto by_omega = [](const ModeInfo& a, const ModeInfo& b) { return a.omega < b.omega; };
+    ModeInfo min_expected = *std::min_element(modes.begin(), modes.end(), by_omega);
+    ModeInfo max_expected = *std::max_element(modes.begin(), modes.end(), by_omega);
+
+    EigenvalueSolver solver(system);
+    ModeInfo min_actual = solver.compute_minimum_frequency();
+    ModeInfo max_actual = solver.compute_maximum_frequency();
+
+    REQUIRE(min_actual.omega == Approx(min_expected.omega).epsilon(1e-8));
+    REQUIRE(min_actual.zeta == Approx(min_expected.zeta).epsilon(1e-8));
+    REQUIRE(max_actual.omega == Approx(max_expected.omega).epsilon(1e-6));
+    REQUIRE(max_actual.zeta == Approx(max_expected.zeta).epsilon(1e-6));
+}
+
+TEST_CASE("eigenvalues-undamped-modes")
+{
+    // Lowest undamped modes of a cantilever beam by subspace iteration, compared to the full solution
+
+    System system(MatrixStorage::Sparse);
+
+    std::vector<Node> nodes;
+    for(size_t i = 0; i < 21; ++i) {
+        bool active = (i != 0);
+        nodes.push_back(system.create_node({active, active, active}, {0.05*i, 0.0, 0.0}));
+    }
+
+    for(size_t i = 0; i < 20; ++i) {
+        BeamElement element(system, nodes[i], nodes[i+1], 0.5, 0.05);
+        element.set_reference_angles(0.0, 0.0);
+        element.set_stiffness(5000.0, 2.0, 0.1);
+        system.mut_elements().add(element);
+    }
+
+    Eigen::GeneralizedSelfAdjointEigenSolver<MatrixXd> reference(system.get_K().to_dense(), system.get_M().asDiagonal());
+
+    VectorXd omega;
+    MatrixXd modes;
+    EigenvalueSolver solver(system);
+    solver.compute_undamped_modes(4, omega, modes);
+
+    REQUIRE(omega.size() == 4);
+    for(int i = 0; i < 4; ++i) {
+        REQUIRE(omega(i) == Approx(std::sqrt(reference.eigenvalues()(i))).epsilon(1e-8));
+
+        // Mass-normalized eigenvector
+        VectorXd x = modes.col(i);
+        REQUIRE(x.dot(system.get_M().cwiseProduct(x)) == Approx(1.0).epsilon(1e-8));
+        REQUIRE((system.get_K().multiply(x) - omega(i)*omega(i)*system.get_M().cwiseProduct(x)).norm() <= 1e-4*omega(i)*omega(i)*system.get_M().cwiseProduct(x).norm());
+    }
+}
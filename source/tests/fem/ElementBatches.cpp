@@ -0,0 +1,78 @@
+#include "solver/fem/elements/ConstraintElement.hpp"
+#include "tests/TestSystems.hpp"
+#include <catch2/catch.hpp>
+
+TEST_CASE("element-batches")
+{
+    // Evaluate a system of beam, bar, mass and constraint elements in a deformed and moving state with and without
+    // batching of the elements and compare the masses, internal forces, tangent stiffness and energies.
+    // Afterwards modify some elements through the container and through references that were kept from before the
+    // last evaluation, and check that the batches are updated.
+
+    System system;
+    BeamWithString beam = create_beam_with_string(system, 5);
+    system.mut_elements().add(MassElement(system, beam.nodes.back(), 0.1, 0.01), "masses");
+    system.mut_elements().add(ConstraintElement(system, beam.nodes[2], beam.node_string, 100.0), "constraint");
+
+    VectorXd u = system.get_u();
+    VectorXd v(system.dofs());
+    for(int i = 0; i < u.size(); ++i) {
+        u(i) += 0.01*std::sin(1.0 + i);
+        v(i) = std::cos(2.0*i);
+    }
+
+    system.set_u(u);
+    system.set_v(v);
+
+    auto evaluate = [&]() {
+        std::vector<double> energies;
+        for(std::string key: {"beams", "string", "masses", "constraint"}) {
+            energies.push_back(system.get_elements().get_potential_energy(key));
+            energies.push_back(system.get_elements().get_kinetic_energy(key));
+        }
+
+        return std::make_tuple(system.get_q(), system.get_M(), energies, system.get_K().to_dense());
+    };
+
+    auto check = [](const auto& a, const auto& b) {
+        REQUIRE(std::get<0>(a).isApprox(std::get<0>(b), 1e-12));
+        REQUIRE(std::get<1>(a).isApprox(std::get<1>(b), 1e-12));
+        for(size_t i = 0; i < std::get<2>(a).size(); ++i) {
+            REQUIRE(std::get<2>(a)[i] == Approx(std::get<2>(b)[i]).epsilon(1e-12));
+        }
+
+        REQUIRE(std::get<3>(a).isApprox(std::get<3>(b), 1e-12));
+    };
+
+    system.mut_elements().set_batching(false);
+    auto individual = evaluate();
+
+    system.mut_elements().set_batching(true);
+    check(evaluate(), individual);
+
+    // Modifications through the container while batching is enabled
+    for(auto& element: system.mut_elements().group<BarElement>("string")) {
+        element.set_length(0.55);
+    }
+
+    system.mut_elements().front<MassElement>("masses").set_node(beam.nodes[3]);
+    auto batched = evaluate();
+
+    system.mut_elements().set_batching(false);
+    check(evaluate(), batched);
+
+    // Modifications through kept references
+    system.mut_elements().set_batching(true);
+    auto& first_beam = system.mut_elements().front<BeamElement>("beams");
+    auto& last_bar = system.mut_elements().back<BarElement>("string");
+    evaluate();
+
+    first_beam.set_stiffness(3000.0, 1.5, 0.2);
+    first_beam.set_damping(0.2);
+    last_bar.set_stiffness(700.0);
+    batched = evaluate();
+
+    system.mut_elements().set_batching(false);
+    check(evaluate(), batched);
+    REQUIRE(!std::get<0>(batched).isApprox(std::get<0>(individual), 1e-6));
+}
@@ -51,3 +51,86 @@ TEST_CASE("harmonic-oscillator")
         REQUIRE(error_v < 0.50e-4);
     }
 }
+
+TEST_CASE("harmonic-oscillator-event")
+{
+    // Undamped oscillator that is stopped when the mass passes through the equilibrium position, which happens at t = T/4.
+    // The event must be located much more precisely than the timestep, also with adaptive timesteps.
+    double l = 1.0;
+    double k = 100.0;
+    double m = 5.0;
+    double s0 = 0.1;
+
+    double T = 2.0*M_PI/std::sqrt(k/m);
+
+    for(bool adaptive: {false, true}) {
+        System system;
+        Node node_a = system.create_node({ false, false, false }, {    0.0, 0.0, 0.0 });
+        Node node_b = system.create_node({ true, false, false },  { l + s0, 0.0, 0.0 });
+
+        system.mut_elements().add(BarElement(system, node_a, node_b, l, l*k, 0.0, 0.0));
+        system.mut_elements().add(MassElement(system, node_b, m, 0.0));
+
+        double dt = 0.01;
+        DynamicSolver solver(system, dt, 1000.0, [&]{ return system.get_t() >= T; });
+        solver.set_event([&]{ return l - system.get_u(node_b.x); });
+        if(adaptive) {
+            solver.set_adaptive(0.5, TimestepMethod::Gershgorin);
+        }
+
+        while(solver.step());
+
+        REQUIRE(system.get_t() == Approx(T/4.0).margin(1e-2*dt));
+        REQUIRE(std::abs(system.get_u(node_b.x) - l) < 1e-4*s0);
+        REQUIRE(system.get_v(node_b.x) == Approx(-s0*std::sqrt(k/m)).epsilon(1e-3));
+
+        // Event function that is already non-negative at the start: The simulation stops after the first substep
+        DynamicSolver solver_start(system, 1e-4, 1000.0, [&]{ return system.get_t() >= T; });
+        solver_start.set_event([&]{ return 1.0; });
+
+        double t_0 = system.get_t();
+        REQUIRE(!solver_start.step());
+        REQUIRE(system.get_t() == Approx(t_0 + 1e-4));
+    }
+}
+
+TEST_CASE("harmonic-oscillator-implicit")
+{
+    // Damped oscillator integrated with the generalized-alpha method, compared to the analytical solution.
+    // With a timestep beyond the stability limit of the central difference method the solution must stay bounded.
+    double l = 1.0;
+    double k = 100.0;
+    double d = 10.0;
+    double m = 5.0;
+    double s0 = 0.1;
+
+    double delta = d/(2.0*m);
+    double omega0 = std::sqrt(k/m);
+    double omega = std::sqrt(omega0*omega0 - delta*delta);
+    double T = 2.0*M_PI/omega;
+
+    auto simulate = [&](double dt, double t_end, const std::function<void(double, double)>& check) {
+        System system;
+        Node node_a = system.create_node({ false, false, false }, {    0.0, 0.0, 0.0 });
+        Node node_b = system.create_node({ true, false, false },  { l + s0, 0.0, 0.0 });
+
+        system.mut_elements().add(BarElement(system, node_a, node_b, l, l*k, l*d, 0.0));
+        system.mut_elements().add(MassElement(system, node_b, m, 0.0));
+
+        DynamicSolver solver(system, dt, 1.0/dt, [&]{ return system.get_t() >= t_end; });
+        solver.set_generalized_alpha(0.8, 0.5);
+        while(solver.step()) {
+            check(system.get_t(), system.get_u(node_b.x) - l);
+        }
+    };
+
+    simulate(0.001, T, [&](double t, double s_num) {
+        double s_ref = std::exp(-delta*t)*(delta/omega*s0*std::sin(omega*t) + s0*std::cos(omega*t));
+        REQUIRE(std::abs(s_num - s_ref) < 1e-4*s0);
+    });
+
+    double dt = 2.5/omega0;
+    simulate(dt, 20.0*T, [&](double, double s_num) {
+        REQUIRE(std::abs(s_num) <= s0);
+    });
+}
@@ -0,0 +1,47 @@
+#include "solver/fem/System.hpp"
+#include "tests/TestSystems.hpp"
+#include "solver/fem/LinearSolver.hpp"
+#include "solver/fem/StaticSolver.hpp"
+#include <catch2/catch.hpp>
+
+TEST_CASE("linear-solver-factorizations")
+{
+    for(MatrixStorage storage: {MatrixStorage::Dense, MatrixStorage::Sparse})
+    {
+        System system(storage);
+        std::vector<Node> nodes = create_cantilever(system, 10, 1.0, 1000.0, 10.0);
+
+        MatrixXd K = system.get_K().to_dense();
+        VectorXd b = VectorXd::LinSpaced(system.dofs(), -1.0, 1.0);
+
+        for(Factorization method: {Factorization::Automatic, Factorization::DenseLDLT, Factorization::BandedLDLT, Factorization::SparseLDLT})
+        {
+            LinearSolver solver(method);
+            REQUIRE(solver.factorize(system.get_K()));
+
+            VectorXd x = solver.solve(b);
+            REQUIRE((K*x).isApprox(b, 1e-10));
+        }
+    }
+}
+
+TEST_CASE("linear-solver-static-solutions")
+{
+    // Solving the same nonlinear problem with different factorizations must lead to the same result
+    auto solve = [](MatrixStorage storage, Factorization method) {
+        System system(storage);
+        std::vector<Node> nodes = create_cantilever(system, 10, 1.0, 1000.0, 10.0);
+
+        system.set_p(nodes.back().y, 20.0);
+        StaticSolverLC solver(system, {method});
+        REQUIRE(solver.solve().outcome == StaticSolver::Info::Success);
+
+        return system.get_u();
+    };
+
+    VectorXd u_ref = solve(MatrixStorage::Dense, Factorization::DenseLDLT);
+
+    REQUIRE(solve(MatrixStorage::Dense, Factorization::BandedLDLT).isApprox(u_ref, 1e-8));
+    REQUIRE(solve(MatrixStorage::Sparse, Factorization::BandedLDLT).isApprox(u_ref, 1e-8));
+    REQUIRE(solve(MatrixStorage::Sparse, Factorization::SparseLDLT).isApprox(u_ref, 1e-8));
+}
@@ -0,0 +1,90 @@
+#include "solver/fem/System.hpp"
+#include "tests/TestSystems.hpp"
+#include "solver/fem/StaticSolver.hpp"
+#include <catch2/catch.hpp>
+#include <functional>
+#include <vector>
+
+// Cantilever beam under an increasing tip load, solved in ten load steps with the given solver options.
+// Returns the equilibrium states and passes the info of each successful solution to the callback.
+static std::vector<VectorXd> solve_cantilever(const StaticSolverOptions& options, const std::function<void(const StaticSolver::Info&)>& callback)
+{
+    unsigned N = 15;
+    double L = 2.0;
+    double EA = 2.07e9;
+    double EI = 1.725e6;
+    double F0 = 3.0*EI/(L*L);
+
+    System system;
+    std::vector<Node> nodes = create_cantilever(system, N, L, EA, EI);
+
+    StaticSolverLC solver(system, options);
+    std::vector<VectorXd> states;
+
+    for(unsigned k = 1; k <= 10; ++k) {
+        system.set_p(nodes[N].y, 0.1*k*F0);
+        StaticSolver::Info info = solver.solve();
+
+        REQUIRE(info.outcome == StaticSolver::Info::Success);
+        callback(info);
+        states.push_back(system.get_u());
+    }
+
+    return states;
+}
+
+TEST_CASE("newton-strategies-cantilever")
+{
+    // Cantilever beam under an increasing tip load, solved in several load steps with each strategy.
+    // All strategies have to reach the same equilibrium states, the modified ones with fewer factorizations.
+
+    auto simulate = [&](NewtonStrategy strategy, unsigned& factorizations) {
+        factorizations = 0;
+        return solve_cantilever({Factorization::Automatic, strategy}, [&](const StaticSolver::Info& info) {
+            REQUIRE(info.solves >= info.iterations);
+            REQUIRE(info.evaluations > info.iterations);
+            factorizations += info.factorizations;
+        });
+    };
+
+    unsigned n_full, n_modified, n_bfgs;
+    auto states_full = simulate(NewtonStrategy::Full, n_full);
+    auto states_modified = simulate(NewtonStrategy::Modified, n_modified);
+    auto states_bfgs = simulate(NewtonStrategy::BFGS, n_bfgs);
+
+    for(size_t k = 0; k < states_full.size(); ++k) {
+        REQUIRE(states_modified[k].isApprox(states_full[k], 1e-4));
+        REQUIRE(states_bfgs[k].isApprox(states_full[k], 1e-4));
+    }
+
+    REQUIRE(n_modified < n_full);
+    REQUIRE(n_bfgs < n_full);
+}
+
+TEST_CASE("line-search-cantilever")
+{
+    // Same cantilever problem, solved with each line search method.
+    // All methods have to reach the same equilibrium states, the Armijo line search with fewer residual evaluations than the golden section search.
+
+    auto simulate = [&](LineSearch line_search, unsigned& evaluations) {
+        evaluations = 0;
+        return solve_cantilever({Factorization::Automatic, NewtonStrategy::Full, line_search}, [&](const StaticSolver::Info& info) {
+            if(line_search == LineSearch::None) {
+                REQUIRE(info.evaluations == info.iterations + 1);
+            }
+            evaluations += info.evaluations;
+        });
+    };
+
+    unsigned n_none, n_armijo, n_golden;
+    auto states_none = simulate(LineSearch::None, n_none);
+    auto states_armijo = simulate(LineSearch::Armijo, n_armijo);
+    auto states_golden = simulate(LineSearch::GoldenSection, n_golden);
+
+    for(size_t k = 0; k < states_golden.size(); ++k) {
+        REQUIRE(states_none[k].isApprox(states_golden[k], 1e-4));
+        REQUIRE(states_armijo[k].isApprox(states_golden[k], 1e-4));
+    }
+
+    REQUIRE(n_armijo < n_golden);
+}
@@ -0,0 +1,68 @@
+#include "solver/fem/elements/ContactHandler.hpp"
+#include "tests/TestSystems.hpp"
+#include <catch2/catch.hpp>
+
+TEST_CASE("parallel-assembly")
+{
+    // Assemble the internal forces, stiffness and damping of a beam with a string and contact serially and with
+    // different numbers of threads. The results must agree up to rounding and be bitwise identical in deterministic mode.
+    // Each run uses a new system, so the sparsity pattern is built by the first parallel assembly. The string center is then
+    // moved into contact with the beam, which adds the entries of the new contact pair to the pattern during a parallel assembly.
+
+    using Results = std::vector<std::tuple<VectorXd, MatrixXd, MatrixXd>>;
+    auto assemble = [&](unsigned threads, bool deterministic) {
+        System system(MatrixStorage::Sparse);
+        BeamWithString beam = create_beam_with_string(system, 20, 0.05);
+
+        ContactHandler contact(system, ContactForce(1000.0, 0.01));
+        for(size_t i = 0; i < 20; ++i) {
+            contact.add_segment(beam.nodes[i], beam.nodes[i+1], 0.01, 0.01);
+        }
+
+        contact.add_point(beam.node_string);
+        system.mut_elements().add(contact, "contact");
+        system.mut_elements().set_parallel(threads, deterministic);
+
+        VectorXd u = system.get_u();
+        VectorXd v(system.dofs());
+        for(int i = 0; i < u.size(); ++i) {
+            u(i) += 0.01*std::sin(1.0 + i);
+            v(i) = std::cos(2.0*i);
+        }
+
+        Results results;
+        for(bool in_contact: {false, true}) {
+            if(in_contact) {
+                u(beam.node_string.y.index) = 0.09;    // Magic number
+            }
+
+            system.set_u(u);
+            system.set_v(v);
+
+            results.emplace_back(system.get_q(), system.get_K().to_dense(), system.get_D().to_dense());
+            REQUIRE((system.get_elements().get_potential_energy("contact") > 0.0) == in_contact);
+        }
+
+        return results;
+    };
+
+    Results serial = assemble(1, false);
+    for(unsigned threads: {2, 3, 8}) {
+        Results parallel = assemble(threads, false);
+        for(size_t k = 0; k < serial.size(); ++k) {
+            REQUIRE(std::get<0>(parallel[k]).isApprox(std::get<0>(serial[k]), 1e-12));
+            REQUIRE(std::get<1>(parallel[k]).isApprox(std::get<1>(serial[k]), 1e-12));
+            REQUIRE(std::get<2>(parallel[k]).isApprox(std::get<2>(serial[k]), 1e-12));
+        }
+    }
+
+    Results reference = assemble(1, true);
+    for(unsigned threads: {2, 3, 8}) {
+        Results parallel = assemble(threads, true);
+        for(size_t k = 0; k < reference.size(); ++k) {
+            REQUIRE(std::get<0>(parallel[k]) == std::get<0>(reference[k]));
+            REQUIRE(std::get<1>(parallel[k]) == std::get<1>(reference[k]));
+            REQUIRE(std::get<2>(parallel[k]) == std::get<2>(reference[k]));
+        }
+    }
+}
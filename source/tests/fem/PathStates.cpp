@@ -0,0 +1,131 @@
+#include "solver/fem/System.hpp"
+#include "solver/fem/PathStates.hpp"
+#include <catch2/catch.hpp>
+
+TEST_CASE("path-states-interpolation")
+{
+    // Displacements and forces that are cubic polynomials of the path parameter are interpolated exactly
+    // from unevenly spaced states with an interpolation order of three
+
+    System system;
+    system.create_node({true, true, true}, {0.0, 0.0, 0.0});
+
+    auto u_exact = [&](double s) {
+        return Vector<3>{1.0 + s, s*s - 2.0*s, 0.5*s*s*s};
+    };
+
+    auto p_exact = [&](double s) {
+        return Vector<3>{s*s*s, -s, 2.0};
+    };
+
+    auto set_state = [&](double s) {
+        system.set_u(u_exact(s));
+        system.set_p(p_exact(s));
+    };
+
+    PathStates states;
+    for(double s: {0.0, 0.1, 0.15, 0.4, 0.5, 0.9, 1.0}) {
+        set_state(s);
+        states.add_state(s, system);
+    }
+
+    REQUIRE_THROWS(states.add_state(0.95, system));
+
+    for(double s: {0.0, 0.05, 0.3, 0.45, 0.7, 0.95, 1.0}) {
+        set_state(0.0);
+        states.interpolate(s, 3, system);
+
+        REQUIRE(system.get_u().isApprox(u_exact(s), 1e-12));
+        REQUIRE(system.get_p().isApprox(p_exact(s), 1e-12));
+    }
+}
+
+TEST_CASE("path-states-prediction")
+{
+    System system;
+    system.create_node({true, true, true}, {0.0, 0.0, 0.0});
+
+    auto u_linear = [&](double s) {
+        return Vector<3>{1.0 + s, -2.0*s, 0.5};
+    };
+
+    auto u_quadratic = [&](double s) {
+        return Vector<3>{1.0 + s, s*s - 2.0*s, -0.5*s*s};
+    };
+
+    auto add_state = [&](PathStates& states, double s, const Vector<3>& u) {
+        system.set_u(u);
+        system.set_p(Vector<3>{s, 0.0, -s});
+        states.add_state(s, system);
+    };
+
+    SECTION("Empty history")
+    {
+        PathStates states;
+        system.set_u(Vector<3>{1.0, 2.0, 3.0});
+
+        REQUIRE(!states.predict(1.0, 2, system));
+        REQUIRE(!states.restore(system));
+        REQUIRE(system.get_u() == Vector<3>{1.0, 2.0, 3.0});
+    }
+
+    SECTION("Exact extrapolation of linear and quadratic paths")
+    {
+        PathStates linear;
+        PathStates quadratic;
+        for(double s: {0.0, 0.2, 0.5}) {
+            add_state(linear, s, u_linear(s));
+            add_state(quadratic, s, u_quadratic(s));
+        }
+
+        for(double s: {0.6, 1.0, 2.0}) {
+            linear.predict(s, 1, system);
+            REQUIRE(system.get_u().isApprox(u_linear(s), 1e-12));
+            REQUIRE(system.get_p().isApprox(Vector<3>{s, 0.0, -s}, 1e-12));
+
+            quadratic.predict(s, 2, system);
+            REQUIRE(system.get_u().isApprox(u_quadratic(s), 1e-12));
+        }
+    }
+
+    SECTION("Order is reduced while there are fewer states")
+    {
+        PathStates states;
+
+        // One state: Constant prediction
+        add_state(states, 0.0, u_quadratic(0.0));
+        states.predict(0.5, 2, system);
+        REQUIRE(system.get_u().isApprox(u_quadratic(0.0), 1e-12));
+
+        // Two states: Linear prediction through both of them
+        add_state(states, 0.2, u_quadratic(0.2));
+        states.predict(0.5, 2, system);
+        Vector<3> u_secant = u_quadratic(0.2) + (0.5 - 0.2)/0.2*(u_quadratic(0.2) - u_quadratic(0.0));
+        REQUIRE(system.get_u().isApprox(u_secant, 1e-12));
+        REQUIRE(states.size() == 2);
+    }
+
+    SECTION("State with equal parameter replaces the last one")
+    {
+        PathStates states;
+        add_state(states, 0.0, u_linear(0.0));
+        add_state(states, 0.2, Vector<3>{9.0, 9.0, 9.0});
+        add_state(states, 0.2, u_linear(0.2));
+        REQUIRE(states.size() == 2);
+
+        states.predict(0.5, 1, system);
+        REQUIRE(system.get_u().isApprox(u_linear(0.5), 1e-12));
+    }
+
+    SECTION("Restore the last state")
+    {
+        PathStates states;
+        add_state(states, 0.0, u_linear(0.0));
+        add_state(states, 0.2, u_linear(0.2));
+
+        states.predict(0.5, 1, system);
+        REQUIRE(states.restore(system));
+        REQUIRE(system.get_u() == u_linear(0.2));
+        REQUIRE(system.get_p() == Vector<3>{0.2, 0.0, -0.2});
+    }
+}
@@ -0,0 +1,49 @@
+#include "solver/fem/System.hpp"
+#include "solver/fem/DynamicSolver.hpp"
+#include "solver/fem/elements/BarElement.hpp"
+#include "solver/fem/elements/MassElement.hpp"
+#include <catch2/catch.hpp>
+
+TEST_CASE("subcycling")
+{
+    // Heavy mass on a soft spring with a light mass attached by a stiff spring. The stiff spring is integrated with
+    // substeps and a timestep at which the central difference method alone would be unstable.
+    // The results must agree with the plain central difference method at a small timestep.
+
+    auto create_system = [](System& system) {
+        Node node_a = system.create_node({false, false, false}, {0.0, 0.0, 0.0});
+        Node node_b = system.create_node({true, false, false}, {1.1, 0.0, 0.0});
+        Node node_c = system.create_node({true, false, false}, {1.6, 0.0, 0.0});
+
+        system.mut_elements().add(BarElement(system, node_a, node_b, 1.0, 100.0, 0.0, 0.0), "soft");
+        system.mut_elements().add(BarElement(system, node_b, node_c, 0.5, 5e4, 0.0, 0.0), "stiff");
+        system.mut_elements().add(MassElement(system, node_b, 5.0), "masses");
+        system.mut_elements().add(MassElement(system, node_c, 0.01), "masses");
+    };
+
+    System system_ref;
+    create_system(system_ref);
+
+    System system_sub;
+    create_system(system_sub);
+
+    double T = 2.0;
+    double omega_stiff = DynamicSolver::estimate_max_frequency(system_sub, std::vector<std::string>{"stiff"});
+    double omega_soft = DynamicSolver::estimate_max_frequency(system_sub, std::vector<std::string>{"soft"});
+    REQUIRE(omega_stiff > 100.0*omega_soft);
+
+    double dt = 0.0035;
+    REQUIRE(dt > 2.0/omega_stiff);
+
+    double dt_ref = 1e-5;
+    DynamicSolver solver_ref(system_ref, dt_ref, 1.0/dt_ref, [&]{ return false; });
+    DynamicSolver solver_sub(system_sub, dt, 100.0, [&]{ return system_sub.get_t() >= T; }, {{{"stiff"}, 16}});
+
+    while(solver_sub.step()) {
+        while(system_ref.get_t() < system_sub.get_t() - 0.5*dt_ref) {
+            solver_ref.step();
+        }
+        REQUIRE(std::abs(system_sub.get_u()(0) - system_ref.get_u()(0)) < 1e-3);
+        REQUIRE(std::abs(system_sub.get_u()(1) - system_ref.get_u()(1)) < 1e-3);
+    }
+}
@@ -0,0 +1,56 @@
+#include "solver/fem/SystemMatrix.hpp"
+#include "tests/TestSystems.hpp"
+#include <catch2/catch.hpp>
+
+TEST_CASE("system-matrix-sparse-pattern")
+{
+    SystemMatrix matrix(MatrixStorage::Sparse);
+    matrix.resize(3);
+    size_t revision = matrix.pattern_revision();
+
+    // First assembly creates the pattern
+    matrix.set_zero();
+    matrix.add(0, 0, 1.0);
+    matrix.add(2, 1, 2.0);
+    matrix.add(0, 0, 3.0);
+    matrix.finalize();
+
+    REQUIRE(matrix.pattern_revision() == revision + 1);
+    REQUIRE(matrix.to_dense() == (MatrixXd(3, 3) << 4.0, 0.0, 0.0, 0.0, 0.0, 0.0, 0.0, 2.0, 0.0).finished());
+
+    // Reassembly within the pattern keeps the revision
+    matrix.set_zero();
+    matrix.add(2, 1, 5.0);
+    matrix.finalize();
+
+    REQUIRE(matrix.pattern_revision() == revision + 1);
+    REQUIRE(matrix.sparse().nonZeros() == 2);
+    REQUIRE(matrix.to_dense() == (MatrixXd(3, 3) << 0.0, 0.0, 0.0, 0.0, 0.0, 0.0, 0.0, 5.0, 0.0).finished());
+
+    // Entries outside of the pattern extend it
+    matrix.set_zero();
+    matrix.add(1, 2, 1.0);
+    matrix.finalize();
+
+    REQUIRE(matrix.pattern_revision() == revision + 2);
+    REQUIRE(matrix.sparse().nonZeros() == 3);
+    REQUIRE(matrix.max_coeff() == 1.0);
+}
+
+TEST_CASE("system-matrix-dense-vs-sparse")
+{
+    // Assemble the stiffness and damping matrices of a beam with a string attached
+    // with both storage formats and compare the results
+    auto assemble = [](MatrixStorage storage) {
+        System system(storage);
+        create_beam_with_string(system, 5);
+
+        return std::make_pair(system.get_K().to_dense(), system.get_D().to_dense());
+    };
+
+    auto dense = assemble(MatrixStorage::Dense);
+    auto sparse = assemble(MatrixStorage::Sparse);
+
+    REQUIRE(dense.first.isApprox(sparse.first, 1e-12));
+    REQUIRE(dense.second.isApprox(sparse.second, 1e-12));
+}
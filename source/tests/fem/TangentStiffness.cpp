@@ -35,7 +35,7 @@ MatrixXd numeric_tangent_stiffness(System& system, double h = 1e-8)
 
 void check_stiffness_matrix(System& system)
 {
-    MatrixXd K_ana = system.get_K();
+    MatrixXd K_ana = system.get_K().to_dense();
     MatrixXd K_num = numeric_tangent_stiffness(system);
 
     REQUIRE(K_ana.isApprox(K_num, 1e-5));                   // Compare to numeric derivatives
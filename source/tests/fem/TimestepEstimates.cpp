@@ -0,0 +1,28 @@
+#include "solver/fem/DynamicSolver.hpp"
+#include "tests/TestSystems.hpp"
+#include <catch2/catch.hpp>
+
+TEST_CASE("timestep-estimates")
+{
+    // Estimates of the highest natural frequency of a curved beam with a string attached, compared to the exact value.
+    // The element and Gershgorin bounds must not be lower, the power iteration not higher than the exact value.
+
+    System system(MatrixStorage::Sparse);
+    create_beam_with_string(system, 20);
+
+    double omega_exact = DynamicSolver::estimate_max_frequency(system, TimestepMethod::Eigenvalues);
+    double omega_element = DynamicSolver::estimate_max_frequency(system, TimestepMethod::ElementBound);
+    double omega_gershgorin = DynamicSolver::estimate_max_frequency(system, TimestepMethod::Gershgorin);
+    double omega_power = DynamicSolver::estimate_max_frequency(system, TimestepMethod::PowerIteration);
+    double omega_automatic = DynamicSolver::estimate_max_frequency(system, TimestepMethod::Automatic);
+
+    REQUIRE(omega_element >= omega_exact*(1.0 - 1e-12));
+    REQUIRE(omega_gershgorin >= omega_exact*(1.0 - 1e-12));
+    REQUIRE(omega_power <= omega_exact*(1.0 + 1e-12));
+    REQUIRE(omega_automatic == omega_exact);    // Small system
+
+    // Magic numbers: Loose limits on how far off the estimates may be for this system
+    REQUIRE(omega_element < 2.0*omega_exact);
+    REQUIRE(omega_gershgorin < 2.0*omega_exact);
+    REQUIRE(omega_power > 0.5*omega_exact);
+}
@@ -0,0 +1,27 @@
+#include "solver/model/BowModel.hpp"
+#include <catch2/catch.hpp>
+
+TEST_CASE("braced-state-fine-mesh")
+{
+    // Straight bow with a stiff handle section and reinforced tips (like the Mollegabet example), braced with a fine mesh.
+    // The static solver doesn't converge for the stress-free string that the search for the string length starts with,
+    // which must not abort the setup. The string length must agree with the one from a coarse mesh.
+
+    InputData input;
+    input.materials[0].rho = 645.0;
+    input.materials[0].E = 10.6e9;
+    input.layers[0].height = {{0.0, 0.038}, {0.025, 0.038}, {0.11, 0.012}, {0.305, 0.0115}, {0.52, 0.012}, {0.555, 0.022}, {0.97, 0.023}, {1.0, 0.01}};
+    input.width = {{0.0, 0.0254}, {0.025, 0.0254}, {0.1, 0.04}, {0.47, 0.04}, {0.595, 0.02}, {1.0, 0.015875}};
+    input.settings.n_draw_steps = 2;
+
+    input.settings.n_limb_elements = 40;
+    input.settings.n_string_elements = 45;
+    OutputData coarse = BowModel::simulate(input, SimulationMode::Static, [](int, int){ });
+
+    input.settings.n_limb_elements = 150;
+    input.settings.n_string_elements = 100;
+    OutputData fine = BowModel::simulate(input, SimulationMode::Static, [](int, int){ });
+
+    REQUIRE(fine.setup.string_length == Approx(coarse.setup.string_length).epsilon(1e-2));
+    REQUIRE(fine.statics.states.draw_length.front() == Approx(input.dimensions.brace_height).epsilon(1e-6));
+}
@@ -0,0 +1,42 @@
+#include "solver/model/BowModel.hpp"
+#include "solver/fem/EigenvalueSolver.hpp"
+#include "solver/fem/elements/BeamElement.hpp"
+#include <catch2/catch.hpp>
+
+TEST_CASE("limb-damping")
+{
+    // Damping of a curved and tapered limb, clamped at its base, tuned on the reduced modal basis. The damping ratio
+    // of the lowest mode of the full damped system must match the target, also for a fine mesh and a high damping ratio.
+
+    auto create_limb = [](System& system, size_t n) {
+        std::vector<Node> nodes;
+        for(size_t i = 0; i < n + 1; ++i) {
+            double s = double(i)/n;
+            bool active = (i != 0);
+            nodes.push_back(system.create_node({active, active, active}, {0.8*s, 0.1*s*s, 0.25*s}));    // Magic numbers
+        }
+
+        for(size_t i = 0; i < n; ++i) {
+            double s = (i + 0.5)/n;
+            double w = 1.0 - 0.7*s;    // Relative width
+            BeamElement element(system, nodes[i], nodes[i+1], 0.21*w, system.get_distance(nodes[i], nodes[i+1]));
+            double phi = system.get_angle(nodes[i], nodes[i+1]);
+            element.set_reference_angles(phi - system.get_u(nodes[i].phi), phi - system.get_u(nodes[i+1].phi));    // Stress-free initial state
+            element.set_stiffness(3.6e6*w, 30.0*w, 0.0);
+            system.mut_elements().add(element, "limb");
+        }
+    };
+
+    for(size_t n: {20, 200}) {
+        for(double zeta: {0.05, 0.2}) {
+            System system(MatrixStorage::Sparse);
+            create_limb(system, n);
+
+            double beta = BowModel::tune_damping(system, "limb", zeta);
+            REQUIRE(beta > 0.0);
+
+            EigenvalueSolver solver(system);
+            REQUIRE(solver.compute_minimum_frequency().zeta == Approx(zeta).epsilon(1e-6));
+        }
+    }
+}
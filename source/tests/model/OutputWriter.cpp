@@ -0,0 +1,30 @@
+#include "solver/model/BowModel.hpp"
+#include "solver/model/output/OutputWriter.hpp"
+#include <catch2/catch.hpp>
+#include <filesystem>
+
+TEST_CASE("output-writer")
+{
+    // Results of the default bow written in small chunks during the simulation must be read back as the same output data
+    // as the one of the simulation in memory. No temporary files may be left behind.
+
+    InputData input;
+    input.settings.n_limb_elements = 10;
+    input.settings.n_string_elements = 10;
+
+    std::string path = (std::filesystem::temp_directory_path()/"virtualbow-output-writer.res").string();
+
+    for(SimulationMode mode: {SimulationMode::Static, SimulationMode::Dynamic}) {
+        OutputData expected = BowModel::simulate(input, mode, [](int, int){ });
+        {
+            OutputWriter writer(path, 7);    // Magic number, doesn't divide the number of states
+            BowModel::simulate(input, mode, [](int, int){ }, writer);
+        }
+
+        OutputData actual(path);
+        REQUIRE(nlohmann::json(actual) == nlohmann::json(expected));
+        REQUIRE(!std::filesystem::exists(path + ".time.tmp"));
+
+        std::filesystem::remove(path);
+    }
+}
@@ -0,0 +1,51 @@
+#include "solver/model/BowModel.hpp"
+#include <catch2/catch.hpp>
+#include <filesystem>
+#include <fstream>
+
+TEST_CASE("result-file")
+{
+    // Results of the default bow saved in the columnar result format and in the previous MessagePack format
+    // must both be read back as the same output data
+
+    InputData input;
+    input.settings.n_limb_elements = 10;
+    input.settings.n_string_elements = 10;
+
+    std::string path = (std::filesystem::temp_directory_path()/"virtualbow-result-file.res").string();
+    OutputData expected = BowModel::simulate(input, SimulationMode::Dynamic, [](int, int){ });
+
+    SECTION("Columnar format") {
+        expected.save(path);
+        OutputData actual(path);
+
+        REQUIRE(nlohmann::json(actual) == nlohmann::json(expected));
+        REQUIRE(actual.dynamics.states.x_pos_limb.size() == expected.dynamics.states.time.size());
+        REQUIRE(actual.dynamics.states.x_pos_limb.cols() == size_t(input.settings.n_limb_elements + 1));
+    }
+
+    SECTION("Replacing a mapped file") {
+        // Saving over a file that is still mapped, once from other data and once from its own mapping ("save as")
+        expected.save(path);
+        OutputData mapped(path);
+
+        OutputData other = expected;
+        other.statics.final_draw_force += 1.0;
+        other.save(path);
+        REQUIRE(nlohmann::json(mapped) == nlohmann::json(expected));
+        REQUIRE(nlohmann::json(OutputData(path)) == nlohmann::json(other));
+
+        mapped.save(path);
+        REQUIRE(nlohmann::json(OutputData(path)) == nlohmann::json(expected));
+    }
+
+    SECTION("Previous format") {
+        std::vector<uint8_t> buffer = nlohmann::json::to_msgpack(expected);
+        std::ofstream(path, std::ios::binary).write(reinterpret_cast<const char*>(buffer.data()), buffer.size());
+        OutputData actual(path);
+
+        REQUIRE(nlohmann::json(actual) == nlohmann::json(expected));
+    }
+
+    std::filesystem::remove(path);
+}